@@ -9,12 +9,31 @@
 ---------------------------------------------------------------------*/
 #include "AppWindow.h"
 #include "Resource.h"
+#include <stdio.h>
 #include <gl/GL.h>
 
 #include "AssignmentTests.h"
+#include "TraceEvents.h"
 
 using namespace AssignmentTests;
 
+#ifdef TINYRASTER_ENABLE_STATS
+//Print the counters of the most recently rendered frame to the console
+static void PrintFrameStats(const RasterStats& stats)
+{
+	printf("Primitives: %u lines, %u unfilled polygons, %u filled polygons, %u interpolated polygons, %u textured polygons, %u circles, %u rectangles, %u span lists\n",
+		stats.lines, stats.unfilledPolygons, stats.filledPolygons, stats.interpolatedPolygons, stats.texturedPolygons, stats.circles, stats.rectangles, stats.spanLists);
+	printf("Pixels: %llu written, %llu blended, %llu rejected, %llu occluded\n",
+		stats.pixelsWritten, stats.pixelsBlended, stats.pixelsRejected, stats.pixelsOccluded);
+	printf("Occluded primitives: %u, culled primitives: %u, primitives drawn without clipping: %u\n",
+		stats.occludedPrimitives, stats.culledPrimitives, stats.acceptedPrimitives);
+	printf("Shape cache: %u hits, %u misses\n", stats.shapeCacheHits, stats.shapeCacheMisses);
+	printf("Simplified vertices: %u\n", stats.simplifiedVertices);
+	printf("Scanlines: %llu, edge intersections: %llu, heap allocations: %llu\n",
+		stats.scanlines, stats.edgeIntersections, stats.heapAllocations);
+}
+#endif
+
 AppWindow::AppWindow()
 {
 	mCurrentTest = TEST1;
@@ -23,6 +42,7 @@ AppWindow::AppWindow()
 AppWindow::~AppWindow()
 {
 	delete mRasterizer;
+	delete mTextRenderer;
 }
 
 AppWindow::AppWindow(HINSTANCE hInstance, int width, int height)
@@ -40,6 +60,31 @@ void AppWindow::SetCurrentTestCase(ETEST test)
 	SetWindowTextA(m_hwnd, newtitle);
 
 	mCurrentTest = test;
+
+	BuildScene();
+}
+
+void AppWindow::BuildScene()
+{
+	SceneBuilder builder;
+	Vertex2d line[2] = { { Colour4(1, 1, 1, 1), Vector2(m_width >> 1, m_height >> 1) }, { Colour4(0, 1, 0, 1), mMousePt } };
+
+	AssignmentTests::BuildAssignmentScene(mCurrentTest, builder);
+
+	mScene.Clear();
+	mScene.SetBackground(Colour4(0.1f, 0.1f, 0.1f, 1.0f));
+	mViewNode = mScene.AddGroup(-1);
+	mScene.SetTransform(mViewNode, mView);
+	mScene.AddSceneView(mViewNode, builder.GetView());
+
+	mMouseNode = mScene.AddLines(-1, line, 2);
+	mScene.SetFillMode(mMouseNode, Rasterizer::INTERPOLATED_FILLED);
+}
+
+void AppWindow::ChangeView(const Transform2D& change)
+{
+	mView = change * mView;
+	mScene.SetTransform(mViewNode, mView);
 }
 
 HGLRC AppWindow::CreateOGLContext(HDC hdc)
@@ -141,6 +186,9 @@ BOOL AppWindow::InitWindow(HINSTANCE hInstance, int width, int height)
 	m_height = height;
 
 	mRasterizer = new Rasterizer(m_width, m_height);
+	mRasterizer->SetShapeCacheSize(256);
+	mRetained = false;
+	mTextRenderer = new TextRenderer();
 
 	SetCurrentTestCase(TEST1);
 
@@ -154,9 +202,63 @@ void AppWindow::SetVisible ( BOOL visible )
 
 void AppWindow::Render()
 {
-	PixelRGBA *buffer = mRasterizer->GetFrameBuffer()->GetBuffer();
+	TRACE_SCOPE_ARG("Frame", "test", mCurrentTest + 1);
+
+	Vector2 centre(m_width >> 1, m_height >> 1);
+	Vector2 pt(mMousePt[0], mMousePt[1]);
+
+	Vertex2d c = { Colour4(1, 1, 1, 1), centre };
+	Vertex2d p = { Colour4(0, 1, 0, 1), pt };
+
+	//label the current test and anti-aliasing mode in the top-left corner
+	const char *antialiasNames[] = { "aliased", "analytic AA", "multisample AA" };
+	char label[64];
+
+	sprintf_s(label, "TEST %d - %s%s", mCurrentTest + 1, antialiasNames[mRasterizer->GetAntialiasMode()], mRetained ? " - retained" : "");
+
+	if (mRetained) {
+		Vertex2d line[2] = { c, p };
+
+		mScene.SetVertices(mMouseNode, line, 2);
+		mScene.Update(mRasterizer);
+
+		//the label is not part of the scene, so it is redrawn over every damaged rectangle
+		const std::vector<ClipRect> &damage = mScene.GetDamage();
+
+		for (size_t i = 0; i < damage.size(); i++) {
+			mRasterizer->SetClipRectangle(damage[i].left, damage[i].right, damage[i].bottom, damage[i].top);
+			mTextRenderer->DrawString(mRasterizer, label, 8.0f, m_height - 24.0f, 16.0f, Colour4(1.0f, 1.0f, 1.0f, 1.0f));
+		}
+
+		mRasterizer->SetClipRectangle(0, m_width, 0, m_height);
+	}
+	else {
+		RenderImmediate(c, p, label);
+	}
+
+	{
+		TRACE_SCOPE("Export");
+
+		if (mRasterizer->GetAntialiasMode() == Rasterizer::MULTISAMPLE_ANTIALIAS) {
+			mRasterizer->ResolveMultisample();
+		}
 
+		//uploading bytes moves a quarter of the data of the float framebuffer
+		mDisplayPixels.resize(m_width * m_height * 4);
+		mDisplayConverter.Convert(mRasterizer->GetFrameBuffer()->GetView(0, 0, m_width, m_height), &mDisplayPixels[0], m_width * 4);
+
+		glDrawPixels(m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, &mDisplayPixels[0]);
+	}
+
+	SwapBuffers(m_hdc);
+	return;
+}
+
+void AppWindow::RenderImmediate(const Vertex2d& c, const Vertex2d& p, const char *label)
+{
 	mRasterizer->Clear(Colour4(0.1f, 0.1f, 0.1f, 1.0f));
+	mRasterizer->PushTransform();
+	mRasterizer->SetTransform(mView);
 
 	switch (mCurrentTest) {
 		case TEST1:
@@ -186,21 +288,14 @@ void AppWindow::Render()
 
 	}
 
-	Vector2 centre(m_width >> 1, m_height >> 1);
-	Vector2 pt(mMousePt[0], mMousePt[1]);
-
-	Vertex2d c = { Colour4(1, 1, 1, 1), centre };
-	Vertex2d p = { Colour4(0, 1, 0, 1), pt };
+	mRasterizer->PopTransform();
 
 	mRasterizer->SetGeometryMode(Rasterizer::LINE);
 	mRasterizer->SetFillMode(Rasterizer::INTERPOLATED_FILLED);
 	mRasterizer->DrawLine2D(c, p, 1);
 	mRasterizer->SetFillMode(Rasterizer::SOLID_FILLED);
 
-	glDrawPixels(m_width, m_height, GL_RGBA, GL_FLOAT, buffer);
-
-	SwapBuffers(m_hdc);
-	return;
+	mTextRenderer->DrawString(mRasterizer, label, 8.0f, m_height - 24.0f, 16.0f, Colour4(1.0f, 1.0f, 1.0f, 1.0f));
 }
 
 void AppWindow::Resize( int width, int height )
@@ -274,10 +369,75 @@ BOOL AppWindow::KeyUp(WPARAM key)
 	case VK_F8:
 		SetCurrentTestCase(TEST8);
 		break;
+	case 'A':
+		mRasterizer->SetAntialiasMode(mRasterizer->GetAntialiasMode() == Rasterizer::NO_ANTIALIAS ? Rasterizer::ANALYTIC_ANTIALIAS : Rasterizer::NO_ANTIALIAS);
+		mRasterizer->SetSampleCount(1);
+		break;
+	case 'M':
+		if (mRasterizer->GetAntialiasMode() == Rasterizer::MULTISAMPLE_ANTIALIAS) {
+			mRasterizer->SetAntialiasMode(Rasterizer::NO_ANTIALIAS);
+			mRasterizer->SetSampleCount(1);
+		}
+		else {
+			mRasterizer->SetAntialiasMode(Rasterizer::MULTISAMPLE_ANTIALIAS);
+			mRasterizer->SetSampleCount(4);
+		}
+		break;
+	case 'T':
+		{
+			Framebuffer *framebuffer = mRasterizer->GetFrameBuffer();
+
+			framebuffer->SetLayout(framebuffer->GetLayout() == Framebuffer::TILED ? Framebuffer::LINEAR : Framebuffer::TILED);
+		}
+		break;
+	case 'R':
+		mRetained = !mRetained;
+		break;
+	case 'L':
+		//half a pixel keeps the simplified outlines within the anti-aliased edge of the original
+		mRasterizer->SetSimplifyTolerance(mRasterizer->GetSimplifyTolerance() > 0.0f ? 0.0f : 0.5f);
+		break;
+	case VK_LEFT:
+		ChangeView(Transform2D::Translation(-32.0f, 0.0f));
+		break;
+	case VK_RIGHT:
+		ChangeView(Transform2D::Translation(32.0f, 0.0f));
+		break;
+	case VK_DOWN:
+		ChangeView(Transform2D::Translation(0.0f, -32.0f));
+		break;
+	case VK_UP:
+		ChangeView(Transform2D::Translation(0.0f, 32.0f));
+		break;
+	case VK_PRIOR:
+	case VK_NEXT:
+		{
+			//zoom about the centre of the window
+			float scale = key == VK_PRIOR ? 1.25f : 0.8f;
+			float cx = (float)(m_width >> 1);
+			float cy = (float)(m_height >> 1);
+
+			ChangeView(Transform2D::Translation(cx, cy) * Transform2D::Scale(scale, scale) * Transform2D::Translation(-cx, -cy));
+		}
+		break;
+	case VK_HOME:
+		mView = Transform2D();
+		mScene.SetTransform(mViewNode, mView);
+		break;
+#ifdef TINYRASTER_ENABLE_STATS
+	case VK_F10:
+		PrintFrameStats(mRasterizer->GetFrameStats());
+		break;
+#endif
+#ifdef TINYRASTER_ENABLE_TRACE
+	case VK_F11:
+		printf("Writing tinyraster_trace.json %s\n", Trace::WriteChromeTrace("tinyraster_trace.json") ? "succeeded" : "failed");
+		break;
+#endif
 	}
 
 	mRasterizer->Clear(Colour4(0.1f, 0.1f, 0.1f, 1.0f));
-
+	mScene.Invalidate();
 
 	return TRUE;
 }
\ No newline at end of file
@@ -12,6 +12,9 @@
 #include <Windows.h>
 #include "Rasterizer.h"
 #include "Framebuffer.h"
+#include "TextRenderer.h"
+#include "PixelConverter.h"
+#include "SceneGraph.h"
 
 class AppWindow
 {
@@ -37,10 +40,27 @@ class AppWindow
 		int			m_height;
 
 		Rasterizer	*mRasterizer;		//an instance of rasterizer
+		TextRenderer	*mTextRenderer;	//draws the overlay label
+		PixelConverter	mDisplayConverter;	//packs the framebuffer for display
+		std::vector<unsigned char>	mDisplayPixels;	//RGBA8 copy of the framebuffer uploaded to OpenGL
 		ETEST		mCurrentTest;
+		bool		mRetained;			//draw the test from mScene instead of immediate calls
+		SceneGraph	mScene;				//retained copy of the current test and the mouse line
+		int			mMouseNode;			//node of the mouse line in mScene
+		Transform2D	mView;				//pan and zoom applied to the test, not to the mouse line and label
+		int			mViewNode;			//group node of the test in mScene, transformed by mView
 
 		void SetCurrentTestCase(ETEST test);
 
+		//Rebuild mScene from the current test
+		void BuildScene();
+
+		//Pan or zoom the test by composing a transform after the current view
+		void ChangeView(const Transform2D& change);
+
+		//Clear the framebuffer and draw the current test, the mouse line and the label with immediate calls
+		void RenderImmediate(const Vertex2d& c, const Vertex2d& p, const char *label);
+
 	protected:
 
 		HGLRC CreateOGLContext (HDC hdc);
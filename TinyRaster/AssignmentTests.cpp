@@ -104,4 +104,53 @@ namespace AssignmentTests {
 			rasterizer->DrawCircle2D(*(circles + i), i % 2 ? true : false);
 		}
 	}
+
+	void BuildAssignmentScene(int test, SceneBuilder &builder)
+	{
+		builder.Clear();
+
+		switch (test)
+		{
+		case 0:
+			builder.AddState(Rasterizer::LINE, Rasterizer::SOLID_FILLED, Rasterizer::NO_BLEND);
+			builder.AddLines(lines, sizeof(lines) / sizeof(Vertex2d));
+			break;
+		case 1:
+			builder.AddState(Rasterizer::LINE, Rasterizer::INTERPOLATED_FILLED, Rasterizer::NO_BLEND);
+			builder.AddLines(lines_interp, sizeof(lines_interp) / sizeof(Vertex2d), 10);
+			break;
+		case 2:
+			builder.AddState(Rasterizer::POLYGON, Rasterizer::UNFILLED, Rasterizer::NO_BLEND);
+			builder.AddUnfilledPolygon(rectangle1, 4);
+			builder.AddUnfilledPolygon(triangle, 3);
+			builder.AddUnfilledPolygon(square, 4);
+			builder.AddUnfilledPolygon(pentagon, 5);
+			break;
+		case 3:
+		case 5:
+			builder.AddState(Rasterizer::POLYGON, Rasterizer::SOLID_FILLED, test == 5 ? Rasterizer::ALPHA_BLEND : Rasterizer::NO_BLEND);
+			builder.AddFilledPolygon(rectangle1, 4);
+			builder.AddFilledPolygon(triangle, 3);
+			builder.AddFilledPolygon(square, 4);
+			builder.AddFilledPolygon(pentagon, 5);
+			break;
+		case 4:
+			builder.AddState(Rasterizer::POLYGON, Rasterizer::SOLID_FILLED, Rasterizer::NO_BLEND);
+			builder.AddFilledPolygon(comb, sizeof(comb) / sizeof(Vertex2d));
+			break;
+		case 6:
+			builder.AddState(Rasterizer::POLYGON, Rasterizer::INTERPOLATED_FILLED, Rasterizer::NO_BLEND);
+			builder.AddInterpolatedPolygon(grad_rectangle, 4);
+			builder.AddInterpolatedPolygon(grad_triangle, 3);
+			builder.AddInterpolatedPolygon(grad_square, 4);
+			builder.AddInterpolatedPolygon(grad_pentagon, 5);
+			break;
+		case 7:
+			for (int i = 0; i < (int)(sizeof(circles) / sizeof(Circle2D)); i++)
+			{
+				builder.AddCircles(circles + i, 1, i % 2 ? true : false);
+			}
+			break;
+		}
+	}
 }
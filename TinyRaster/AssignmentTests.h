@@ -11,6 +11,7 @@
 
 #include "TinyRasterTypes.h"
 #include "Rasterizer.h"
+#include "SceneFile.h"
 namespace AssignmentTests {
 	//Test 01: solid lines one pixel thickness
 	void AssignmentTest01(Rasterizer *rasterizer);
@@ -35,4 +36,10 @@ namespace AssignmentTests {
 
 	//Test 08: A mix of filled and unfilled circle
 	void AssignmentTest08(Rasterizer *rasterizer);
+
+	//Record the primitives of a test as a scene, e.g. for a retained SceneGraph
+	//Unfilled circles of test 08 are recorded in their own colour
+	//input:	int test --- index of the test, 0 for Test 01
+	//output:	SceneBuilder &builder --- receives the scene, previous content is discarded
+	void BuildAssignmentScene(int test, SceneBuilder &builder);
 }
\ No newline at end of file
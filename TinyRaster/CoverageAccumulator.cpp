@@ -0,0 +1,232 @@
+#include <math.h>
+#include <limits.h>
+#include <algorithm>
+
+#include "CoverageAccumulator.h"
+
+CoverageAccumulator::CoverageAccumulator()
+{
+	mLeft = 0;
+	mBottom = 0;
+	mWidth = 0;
+	mHeight = 0;
+}
+
+void CoverageAccumulator::Reset(int left, int bottom, int width, int height)
+{
+	//clear rows left unresolved by the previous use, the buffer is otherwise kept zeroed
+	for (int row = 0; row < mHeight; row++)
+	{
+		if (mRowMin[row] <= mRowMax[row])
+		{
+			float *cells = &mArea[row * (mWidth + 2)];
+			std::fill(cells + mRowMin[row], cells + mRowMax[row] + 1, 0.0f);
+		}
+	}
+
+	mLeft = left;
+	mBottom = bottom;
+	mWidth = std::max(width, 0);
+	mHeight = std::max(height, 0);
+
+	size_t cells = (size_t)(mWidth + 2) * mHeight;
+
+	if (mArea.size() < cells)
+	{
+		mArea.resize(cells, 0.0f);
+	}
+
+	mRowMin.assign(mHeight, INT_MAX);
+	mRowMax.assign(mHeight, -1);
+}
+
+void CoverageAccumulator::AddEdge(float x0, float y0, float x1, float y1)
+{
+	x0 -= mLeft;
+	x1 -= mLeft;
+	y0 -= mBottom;
+	y1 -= mBottom;
+
+	if (y0 == y1)
+	{
+		return;
+	}
+
+	//accumulate bottom to top, the direction of the edge becomes the sign of its area
+	float dir = 1.0f;
+
+	if (y0 > y1)
+	{
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+		dir = -1.0f;
+	}
+
+	if (y1 <= 0.0f || y0 >= mHeight)
+	{
+		return;
+	}
+
+	float dxdy = (x1 - x0) / (y1 - y0);
+	float x = x0;
+	int yStart = (int)floorf(y0);
+	int yEnd = std::min((int)ceilf(y1), mHeight);
+	float right = (float)mWidth;
+
+	if (y0 < 0.0f)
+	{
+		x -= y0 * dxdy;
+		yStart = 0;
+	}
+
+	for (int y = yStart; y < yEnd; y++)
+	{
+		float dy = std::min(y + 1.0f, y1) - std::max((float)y, y0);
+		float xNext = x + dxdy * dy;
+		float d = dy * dir;
+
+		//projecting the parts of the edge outside the region onto its left or right side leaves the coverage inside
+		//the region unchanged, a piece crossing a side within the row is cut there so only its outer part is projected
+		float cuts[3];
+		int cutCount = 0;
+
+		if ((x < 0.0f) != (xNext < 0.0f))
+		{
+			cuts[cutCount++] = x / (x - xNext);
+		}
+
+		if ((x < right) != (xNext < right))
+		{
+			cuts[cutCount++] = (x - right) / (x - xNext);
+		}
+
+		if (cutCount == 2 && cuts[0] > cuts[1])
+		{
+			std::swap(cuts[0], cuts[1]);
+		}
+
+		cuts[cutCount++] = 1.0f;
+
+		float t = 0.0f;
+		float xs = x;
+
+		for (int c = 0; c < cutCount; c++)
+		{
+			float xe = c == cutCount - 1 ? xNext : x + (xNext - x) * cuts[c];
+
+			AddRowSegment(y, std::min(std::max(xs, 0.0f), right), std::min(std::max(xe, 0.0f), right), d * (cuts[c] - t));
+
+			t = cuts[c];
+			xs = xe;
+		}
+
+		x = xNext;
+	}
+}
+
+void CoverageAccumulator::AddRowSegment(int row, float xa, float xb, float d)
+{
+	float lo = std::min(xa, xb);
+	float hi = std::max(xa, xb);
+	int loCell = (int)floorf(lo);
+	int hiCell = (int)ceilf(hi);
+	float *cells = &mArea[row * (mWidth + 2)];
+
+	if (hiCell <= loCell + 1)
+	{
+		//the edge stays within one pixel column on this row
+		float mid = 0.5f * (xa + xb) - loCell;
+
+		cells[loCell] += d - d * mid;
+		cells[loCell + 1] += d * mid;
+
+		Touch(row, loCell, loCell + 1);
+	}
+	else
+	{
+		//the edge crosses several columns, distribute the trapezoid areas
+		float s = 1.0f / (hi - lo);
+		float loFrac = lo - loCell;
+		float a0 = 0.5f * s * (1.0f - loFrac) * (1.0f - loFrac);
+		float hiFrac = hi - hiCell + 1.0f;
+		float am = 0.5f * s * hiFrac * hiFrac;
+
+		cells[loCell] += d * a0;
+
+		if (hiCell == loCell + 2)
+		{
+			cells[loCell + 1] += d * (1.0f - a0 - am);
+		}
+		else
+		{
+			float a1 = s * (1.5f - loFrac);
+
+			cells[loCell + 1] += d * (a1 - a0);
+
+			for (int xi = loCell + 2; xi < hiCell - 1; xi++)
+			{
+				cells[xi] += d * s;
+			}
+
+			float a2 = a1 + (hiCell - loCell - 3) * s;
+
+			cells[hiCell - 1] += d * (1.0f - a2 - am);
+		}
+
+		cells[hiCell] += d * am;
+
+		Touch(row, loCell, hiCell);
+	}
+}
+
+void CoverageAccumulator::AddContour(const Vertex2d *vertices, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const Vector2 &p0 = vertices[i].position;
+		const Vector2 &p1 = vertices[i + 1 < count ? i + 1 : 0].position;
+
+		AddEdge(p0[0], p0[1], p1[0], p1[1]);
+	}
+}
+
+bool CoverageAccumulator::ResolveRow(int row, bool evenOdd, float *coverage, int &first, int &last)
+{
+	int rowMin = mRowMin[row];
+	int rowMax = mRowMax[row];
+
+	if (rowMin > rowMax)
+	{
+		return false;
+	}
+
+	float *cells = &mArea[row * (mWidth + 2)];
+	float sum = 0.0f;
+
+	first = rowMin;
+	last = std::min(rowMax, mWidth - 1);
+
+	for (int x = first; x <= last; x++)
+	{
+		sum += cells[x];
+
+		float a = fabsf(sum);
+
+		if (evenOdd)
+		{
+			a = fmodf(a, 2.0f);
+			coverage[x] = a > 1.0f ? 2.0f - a : a;
+		}
+		else
+		{
+			coverage[x] = a < 1.0f ? a : 1.0f;
+		}
+	}
+
+	std::fill(cells + rowMin, cells + rowMax + 1, 0.0f);
+
+	mRowMin[row] = INT_MAX;
+	mRowMax[row] = -1;
+
+	return first <= last;
+}
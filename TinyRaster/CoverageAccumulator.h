@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "TinyRasterTypes.h"
+
+//This class computes exact per-pixel area coverage of polygons using signed-area accumulation,
+//the technique used by font rasterizers. Each edge deposits its signed area into the cells it crosses;
+//a running sum along a row then yields the winding-weighted coverage of every pixel.
+//Pixel (x, y) covers the area [x, x+1) x [y, y+1).
+class CoverageAccumulator
+{
+private:
+	int mLeft;					//left edge of the accumulation region in framebuffer coordinates
+	int mBottom;				//bottom edge of the accumulation region in framebuffer coordinates
+	int mWidth;					//width of the accumulation region
+	int mHeight;				//height of the accumulation region
+	std::vector<float> mArea;	//signed area deltas, mWidth + 2 cells per row
+	std::vector<int> mRowMin;	//first cell touched in each row
+	std::vector<int> mRowMax;	//last cell touched in each row
+
+	inline void Touch(int row, int first, int last)
+	{
+		if (first < mRowMin[row]) { mRowMin[row] = first; }
+		if (last > mRowMax[row]) { mRowMax[row] = last; }
+	}
+
+	//Accumulate a straight piece of an edge within one row, lying inside the region's columns or along one of its sides
+	//input:	int row --- row relative to the bottom of the region
+	//			float xa, float xb --- x of the piece at its start and end, relative to the left of the region
+	//			float d --- signed height of the piece
+	void AddRowSegment(int row, float xa, float xb, float d);
+
+public:
+	CoverageAccumulator();
+
+	//Prepare an empty accumulation region, storage is only reallocated when the region grows
+	//input:	int left, int bottom --- framebuffer position of the region's bottom-left pixel
+	//			int width, int height --- size of the region in pixels
+	void Reset(int left, int bottom, int width, int height);
+
+	//Accumulate a directed edge, the region clips it without changing the coverage inside the region
+	//input:	x0, y0, x1, y1 --- end points of the edge in framebuffer coordinates
+	void AddEdge(float x0, float y0, float x1, float y1);
+
+	//Accumulate every edge of a closed contour
+	void AddContour(const Vertex2d *vertices, int count);
+
+	//Resolve the coverage of a row and clear its accumulation cells for the next use
+	//input:	int row --- row relative to the bottom of the region
+	//			bool evenOdd --- true for the even-odd fill rule, false for non-zero winding
+	//output:	float *coverage --- receives the coverage of pixels [first, last] relative to the left of the region
+	//			int &first, int &last --- range of pixels written to coverage
+	//			returns false if no edge crossed the row
+	bool ResolveRow(int row, bool evenOdd, float *coverage, int &first, int &last);
+
+	inline int Left() const { return mLeft; }
+	inline int Bottom() const { return mBottom; }
+	inline int Width() const { return mWidth; }
+	inline int Height() const { return mHeight; }
+};
@@ -1,22 +1,18 @@
 #include "EdgeBucket.h"
 
-EdgeBucket::EdgeBucket(Vector2* a, Vector2* b) {
-	Vector2 va = *a;
-	Vector2 vb = *b;
-
-	yMin = va[1];
-	if (yMin > vb[1]) {
-		yMin = vb[1];
-		yMax = va[1];
+EdgeBucket::EdgeBucket(const Vector2& a, const Vector2& b) {
+	if (a[1] <= b[1]) {
+		yMin = a[1];
+		yMax = b[1];
+		x = a[0];
+		winding = 1;
 	}
 	else {
-		yMax = vb[1];
+		yMin = b[1];
+		yMax = a[1];
+		x = b[0];
+		winding = -1;
 	}
 
-	x = yMin;
-
-	dX = abs(va[0] - vb[0]);
-	dY = abs(va[1] - vb[1]);
-
-	sum = 0;
-}
\ No newline at end of file
+	dxdy = yMax > yMin ? (b[0] - a[0]) / (b[1] - a[1]) : 0.0f;
+}
@@ -2,15 +2,20 @@
 
 #include "Vector2.h"
 
+//An entry of the polygon edge table used by the scanline fills.
+//The edge crosses the sample rows y with yMin <= y < yMax, so a row passing through a vertex
+//is crossed by exactly one of the two edges meeting there and horizontal edges cross no row.
 class EdgeBucket {
 
 public:
-	EdgeBucket(Vector2* a, Vector2* b);
-	int yMax;
-	int yMin;
-	int x;
-	int sign;
-	int dX;
-	int dY;
-	int sum;
-};
\ No newline at end of file
+	EdgeBucket(const Vector2& a, const Vector2& b);
+
+	//x position of the edge on a sample row in [yMin, yMax)
+	inline float XAt(float y) const { return x + (y - yMin) * dxdy; }
+
+	float yMin;		//lower end of the edge
+	float yMax;		//upper end of the edge
+	float x;		//x position at yMin
+	float dxdy;		//change of x per unit y
+	int winding;	//+1 if the edge runs from a up to b, -1 if it runs down
+};
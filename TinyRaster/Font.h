@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "Vector2.h"
+
+//Outline of a single glyph in font units, y pointing up and the baseline at y = 0
+typedef struct _GlyphOutline
+{
+	float advance;						//horizontal distance to the next glyph's origin
+	std::vector<Vector2> points;		//points of all contours, one contour after another
+	std::vector<int> contourCounts;		//number of points of each contour
+} GlyphOutline;
+
+//This class holds the vector outlines of a font.
+//Outlines are filled with the non-zero winding rule, so overlapping contours merge and holes run opposite to their outer contour.
+//
+//Fonts are loaded from a simple text format:
+//	font <unitsPerEm> <ascent> <descent>
+//	glyph <character code> <advance>
+//	contour
+//	p <x> <y>
+//	...
+//	end
+//where every contour lists its points in order and end closes the glyph. Text after # is a comment.
+class Font
+{
+private:
+	float mUnitsPerEm;			//font units per em, a font drawn at size s scales its outlines by s / mUnitsPerEm
+	float mAscent;				//distance from the baseline to the top of the tallest glyph
+	float mDescent;				//distance from the baseline to the bottom of the lowest glyph
+	std::unordered_map<unsigned int, GlyphOutline> mGlyphs;	//outlines by character code
+
+public:
+	Font();
+
+	//Replace the glyphs with the built-in 5x7 pixel font covering printable ASCII,
+	//every lit pixel of the bitmap becomes part of a square outline
+	void LoadBuiltin();
+
+	//Replace the glyphs with the glyphs of a font file
+	//input:	const char *path --- path of a font in the text format above
+	//output:	false if the file cannot be opened or parsed, the font is then left empty
+	bool Load(const char *path);
+
+	//Get the outline of a character
+	//output:	the outline, or NULL if the font has no glyph for the character
+	const GlyphOutline *GetGlyph(unsigned int code) const;
+
+	inline float GetUnitsPerEm() const { return mUnitsPerEm; }
+	inline float GetAscent() const { return mAscent; }
+	inline float GetDescent() const { return mDescent; }
+};
@@ -7,13 +7,38 @@
 * to use and extend the functionality. The code provided here is functional
 * however the author does not guarantee its performance.
 ---------------------------------------------------------------------*/
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
 #include "Framebuffer.h"
+#include "TraceEvents.h"
+
+//Sample offsets inside a pixel in [0,1), the standard 4x and 8x patterns in 1/16 pixel steps around the centre
+#define SAMPLE_POSITION(x, y) 0.5f + (x) / 16.0f, 0.5f + (y) / 16.0f
+
+static const float SAMPLE_OFFSETS_1X[2] = { 0.5f, 0.5f };
+static const float SAMPLE_OFFSETS_4X[8] = { SAMPLE_POSITION(-2, -6), SAMPLE_POSITION(6, -2), SAMPLE_POSITION(-6, 2), SAMPLE_POSITION(2, 6) };
+static const float SAMPLE_OFFSETS_8X[16] = { SAMPLE_POSITION(1, -3), SAMPLE_POSITION(-1, 3), SAMPLE_POSITION(5, 1), SAMPLE_POSITION(-3, -5),
+	SAMPLE_POSITION(-5, 5), SAMPLE_POSITION(-7, -1), SAMPLE_POSITION(3, 7), SAMPLE_POSITION(7, -7) };
+
+//Below this many expanded pixels the resolve runs on the calling thread only
+static const int RESOLVE_PIXELS_PER_THREAD = 4096;
 
 Framebuffer::Framebuffer()
 {
 	mWidth = 0;
 	mHeight = 0;
+	mPitch = 0;
+	mTilesPerRow = 0;
+	mBufferSize = 0;
+	mLayout = LINEAR;
 	mColourBuffer = NULL;
+	mAllocation = NULL;
+	mSampleCount = 1;
 }
 
 Framebuffer::Framebuffer(int width, int height)
@@ -23,16 +48,285 @@ Framebuffer::Framebuffer(int width, int height)
 
 Framebuffer::~Framebuffer()
 {
-	delete[] mColourBuffer;
+	//PixelRGBA has nothing to release, only the block is freed
+	delete[] mAllocation;
 }
 
 void Framebuffer::InitFramebuffer(int width, int height)
 {
-	int size = width*height;
+	int pixelsPerLine = ALIGNMENT / (int)sizeof(PixelRGBA);
 	mWidth = width;
 	mHeight = height;
+	mPitch = (width + pixelsPerLine - 1) / pixelsPerLine * pixelsPerLine;
+	mTilesPerRow = (width + TILE_SIZE - 1) / TILE_SIZE;
+	mLayout = LINEAR;
+
+	//the tiled layout covers whole tiles, the buffer fits both layouts so switching needs no reallocation
+	int tileRows = (height + TILE_SIZE - 1) / TILE_SIZE;
+	mBufferSize = std::max(mPitch * height, mTilesPerRow * tileRows * TILE_SIZE * TILE_SIZE);
+
+	size_t size = (size_t)mBufferSize;
 
-	mColourBuffer = new PixelRGBA[size];
+	//over-allocate and round the start up to the next line boundary
+	mAllocation = new char[size * sizeof(PixelRGBA) + ALIGNMENT - 1];
+	mColourBuffer = reinterpret_cast<PixelRGBA*>(((uintptr_t)mAllocation + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+	std::uninitialized_fill_n(mColourBuffer, size, PixelRGBA());
+	mSampleCount = 1;
 
 	//memset(mColourBuffer, 0, size*sizeof(PixelRGBA));
 }
+
+FramebufferView Framebuffer::GetView(int x, int y, int width, int height) const
+{
+	FramebufferView view;
+	int x0 = std::max(x, 0);
+	int y0 = std::max(y, 0);
+	int x1 = std::min(x + width, mWidth);
+	int y1 = std::min(y + height, mHeight);
+
+	view.x = x0;
+	view.y = y0;
+	view.width = std::max(x1 - x0, 0);
+	view.height = std::max(y1 - y0, 0);
+	view.pitch = mPitch;
+	view.pixels = NULL;
+	view.framebuffer = this;
+
+	if (view.width == 0 || view.height == 0)
+	{
+		view.width = 0;
+		view.height = 0;
+	}
+	else
+	{
+		view.pixels = GetPixel(x0, y0);
+	}
+
+	return view;
+}
+
+void Framebuffer::SetLayout(Layout layout)
+{
+	if (layout == mLayout)
+	{
+		return;
+	}
+
+	Resolve();
+	ClearSamples();
+
+	std::vector<PixelRGBA> pixels((size_t)mWidth * mHeight);
+
+	for (int y = 0; y < mHeight; y++)
+	{
+		ReadRow(0, y, mWidth, &pixels[(size_t)y * mWidth]);
+	}
+
+	mLayout = layout;
+
+	for (int y = 0; y < mHeight; y++)
+	{
+		for (int x = 0; x < mWidth; x++)
+		{
+			*GetPixel(x, y) = pixels[(size_t)y * mWidth + x];
+		}
+	}
+}
+
+void Framebuffer::ReadRow(int x, int y, int count, PixelRGBA *out) const
+{
+	while (count > 0)
+	{
+		int run = std::min(count, GetRowRun(x));
+
+		memcpy((void*)out, (const void*)GetPixel(x, y), run * sizeof(PixelRGBA));
+		out += run;
+		x += run;
+		count -= run;
+	}
+}
+
+void Framebuffer::ClearStencil(unsigned char value)
+{
+	mStencil.assign((size_t)mWidth * mHeight, value);
+	mStencilRuns.resize(mHeight);
+	mStencilRunValue.assign(mHeight, -1);
+}
+
+void Framebuffer::WriteStencil(int y, int x0, int x1, unsigned char value)
+{
+	if (x0 < x1)
+	{
+		memset(&mStencil[(size_t)y * mWidth + x0], value, x1 - x0);
+		mStencilRunValue[y] = -1;
+	}
+}
+
+const std::vector<StencilRun> &Framebuffer::GetStencilRuns(int y, unsigned char value)
+{
+	std::vector<StencilRun> &runs = mStencilRuns[y];
+
+	if (mStencilRunValue[y] != value)
+	{
+		const unsigned char *row = &mStencil[(size_t)y * mWidth];
+		int x = 0;
+
+		runs.clear();
+
+		while (x < mWidth)
+		{
+			while (x < mWidth && row[x] != value) { x++; }
+
+			StencilRun run;
+
+			run.x0 = x;
+
+			while (x < mWidth && row[x] == value) { x++; }
+
+			run.x1 = x;
+
+			if (run.x0 < run.x1)
+			{
+				runs.push_back(run);
+			}
+		}
+
+		mStencilRunValue[y] = value;
+	}
+
+	return runs;
+}
+
+void Framebuffer::SetSampleCount(int count)
+{
+	if (count != 4 && count != 8)
+	{
+		count = 1;
+	}
+
+	mSampleCount = count;
+	mSampleIndex.assign(count > 1 ? mBufferSize : 0, -1);
+	mSamples.clear();
+	mExpandedPixels.clear();
+}
+
+const float *Framebuffer::GetSampleOffsets() const
+{
+	if (mSampleCount == 4)
+		return SAMPLE_OFFSETS_4X;
+	else if (mSampleCount == 8)
+		return SAMPLE_OFFSETS_8X;
+
+	return SAMPLE_OFFSETS_1X;
+}
+
+void Framebuffer::ClearSamples()
+{
+	//only the expanded pixels need resetting
+	for (size_t i = 0; i < mExpandedPixels.size(); i++)
+	{
+		mSampleIndex[mExpandedPixels[i]] = -1;
+	}
+
+	mSamples.clear();
+	mExpandedPixels.clear();
+}
+
+PixelRGBA *Framebuffer::ExpandPixel(int index)
+{
+	int first = mSampleIndex[index];
+
+	if (first == -1)
+	{
+		first = (int)mSamples.size();
+		mSamples.insert(mSamples.end(), mSampleCount, mColourBuffer[index]);
+		mSampleIndex[index] = first;
+		mExpandedPixels.push_back(index);
+	}
+	else if (first < -1)
+	{
+		//a collapsed pixel is already listed, it takes its old samples back so Resolve() visits it only once
+		first = -2 - first;
+		std::fill(mSamples.begin() + first, mSamples.begin() + first + mSampleCount, mColourBuffer[index]);
+		mSampleIndex[index] = first;
+	}
+
+	return &mSamples[first];
+}
+
+static inline PixelRGBA AverageSamples(const PixelRGBA *samples, int count)
+{
+	PixelRGBA sum = samples[0];
+
+	for (int s = 1; s < count; s++)
+	{
+		sum = sum + samples[s];
+	}
+
+	return sum * (1.0f / count);
+}
+
+void Framebuffer::CollapsePixel(int index)
+{
+	mColourBuffer[index] = AverageSamples(&mSamples[mSampleIndex[index]], mSampleCount);
+
+	//the samples stay in the pool until the next ClearSamples(), ready to be reused if the pixel is expanded again
+	mSampleIndex[index] = -2 - mSampleIndex[index];
+}
+
+//Average the samples of the expanded pixels [begin, end) into the colour buffer
+static void ResolveRange(PixelRGBA *colourBuffer, const int *sampleIndex, const PixelRGBA *samples, const int *pixels, int begin, int end, int sampleCount)
+{
+	TRACE_SCOPE_ARG("ResolveBand", "pixels", end - begin);
+
+	for (int i = begin; i < end; i++)
+	{
+		int first = sampleIndex[pixels[i]];
+
+		//a pixel that was collapsed back to a single colour keeps its colour
+		if (first < 0)
+		{
+			continue;
+		}
+
+		colourBuffer[pixels[i]] = AverageSamples(samples + first, sampleCount);
+	}
+}
+
+void Framebuffer::Resolve(int threads)
+{
+	int count = (int)mExpandedPixels.size();
+
+	if (mSampleCount == 1 || count == 0)
+	{
+		return;
+	}
+
+	TRACE_SCOPE_ARG("Resolve", "pixels", count);
+
+	if (threads <= 0)
+	{
+		threads = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+
+	threads = std::min(threads, (count + RESOLVE_PIXELS_PER_THREAD - 1) / RESOLVE_PIXELS_PER_THREAD);
+
+	std::vector<std::thread> workers;
+	int chunk = (count + threads - 1) / threads;
+
+	//the calling thread resolves the first chunk itself
+	for (int t = 1; t < threads; t++)
+	{
+		int begin = t * chunk;
+		int end = std::min(begin + chunk, count);
+
+		workers.push_back(std::thread(ResolveRange, mColourBuffer, &mSampleIndex[0], &mSamples[0], &mExpandedPixels[0], begin, end, mSampleCount));
+	}
+
+	ResolveRange(mColourBuffer, &mSampleIndex[0], &mSamples[0], &mExpandedPixels[0], 0, std::min(chunk, count), mSampleCount);
+
+	for (size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+}
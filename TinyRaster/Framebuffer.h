@@ -9,15 +9,79 @@
 ---------------------------------------------------------------------*/
 #pragma once
 
+#include <vector>
 #include "TinyRasterTypes.h"
 
+class Framebuffer;
+
+//A run of pixels [x0, x1) in a row
+typedef struct _StencilRun
+{
+	int x0;					//first pixel of the run
+	int x1;					//one past the last pixel of the run
+} StencilRun;
+
+//A rectangle of framebuffer pixels sharing the framebuffer's storage
+//In the linear layout row y of the view starts at pixels + y * pitch,
+//in the tiled layout pixels must be addressed through framebuffer->GetPixel()
+typedef struct _FramebufferView
+{
+	PixelRGBA *pixels;		//bottom-left pixel of the view
+	int x, y;				//position of the bottom-left pixel in the framebuffer
+	int width, height;		//size of the view in pixels, 0 for an empty view
+	int pitch;				//distance between two rows in pixels, the pitch of the framebuffer
+	const Framebuffer *framebuffer;	//the framebuffer owning the pixels, NULL for a plain linear image
+} FramebufferView;
+
 //This class represent a RGBA colour framebuffer
+//
+//Every row starts on a 64 byte boundary, rows are padded to a pitch that is a multiple of 4 pixels.
+//The pixel (x, y) is at GetBuffer()[y * GetPitch() + x], every pixel is 16 byte aligned for SSE.
+//
+//The tiled layout instead stores 8x8 pixel tiles one after another, each tile row-major, so the pixels
+//of small tall shapes share cache lines and pages. A row is then contiguous only within a tile;
+//GetPixel() and GetRowRun()/GetColumnRun() address pixels in either layout.
+//
+//An optional 8-bit stencil plane, allocated by the first ClearStencil(), masks fills to arbitrary shapes.
+//Each row also caches its stencil as runs of pixels holding one value, rebuilt after the row is written,
+//so spans are intersected with whole runs instead of testing the stencil per pixel.
+//
+//With a sample count of 4 or 8 the framebuffer also stores multisampled pixels.
+//A pixel stays a single colour in the colour buffer until a primitive covers only some of its samples,
+//only then it is expanded to per-sample storage in a shared sample pool.
+//Resolve() averages the samples of every expanded pixel back into the colour buffer.
 class Framebuffer
 {
+public:
+	//enum for the pixel memory layout
+	enum Layout {
+		LINEAR = 0,					//rows one after another, mPitch pixels apart
+		TILED						//TILE_SIZE x TILE_SIZE tiles in row-major order, each tile row-major
+	};
+
+	static const int ALIGNMENT = 64;	//alignment of every row in bytes, a cache line
+	static const int TILE_SHIFT = 3;	//log2 of the tile size
+	static const int TILE_SIZE = 1 << TILE_SHIFT;	//width and height of a tile in pixels
+
 private:
 	int	mWidth;					//the width of framebuffer
 	int mHeight;				//the height of framebuffer
-	PixelRGBA *mColourBuffer;	//Storage for RGBA pixels as a linear array
+	int mPitch;					//distance between two rows in pixels
+	int mTilesPerRow;			//number of tiles covering a row in the tiled layout
+	int mBufferSize;			//number of pixels in mColourBuffer, enough for either layout
+	Layout mLayout;				//current pixel layout
+	PixelRGBA *mColourBuffer;	//Storage for RGBA pixels
+	char *mAllocation;			//unaligned block holding mColourBuffer
+
+	int mSampleCount;					//samples per pixel, 1 when multisampling is disabled
+	std::vector<int> mSampleIndex;		//per pixel, first sample in mSamples, -1 if the pixel was never expanded since
+										//the last ClearSamples() or -2 - first once it was collapsed back to one colour
+	std::vector<PixelRGBA> mSamples;	//sample pool of the expanded pixels
+	std::vector<int> mExpandedPixels;	//indices of the expanded pixels, in order of expansion
+
+	std::vector<unsigned char> mStencil;	//stencil value per pixel, mWidth pixels per row, empty until ClearStencil()
+	std::vector<std::vector<StencilRun> > mStencilRuns;	//per row, runs of the pixels whose stencil equals mStencilRunValue
+	std::vector<int> mStencilRunValue;	//per row, the value mStencilRuns was built for, -1 if it must be rebuilt
 
 	//Method for initialise the framebuffer
 	//input:	int width --- width of the buffer to be created
@@ -32,10 +96,117 @@ public:
 
 	inline int GetWidth() { return mWidth; }
 	inline int GetHeight() { return mHeight; }
+	inline int GetPitch() const { return mPitch; }
+	inline int GetBufferSize() const { return mBufferSize; }
+
+	//Change the pixel layout, the pixels are moved into the new layout
+	//Multisampled pixels are resolved and lose their per-sample storage
+	void SetLayout(Layout layout);
+
+	inline Layout GetLayout() const { return mLayout; }
+
+	//Get the linear index of a pixel in the colour buffer
+	inline int PixelIndex(int x, int y) const
+	{
+		if (mLayout == TILED)
+		{
+			int tile = (y >> TILE_SHIFT) * mTilesPerRow + (x >> TILE_SHIFT);
+
+			return (tile << (2 * TILE_SHIFT)) + ((y & (TILE_SIZE - 1)) << TILE_SHIFT) + (x & (TILE_SIZE - 1));
+		}
+
+		return y * mPitch + x;
+	}
+
+	inline PixelRGBA *GetPixel(int x, int y) const
+	{
+		return mColourBuffer + PixelIndex(x, y);
+	}
+
+	//Get the number of pixels from column x to the end of its contiguous run along a row
+	inline int GetRowRun(int x) const
+	{
+		return mLayout == TILED ? TILE_SIZE - (x & (TILE_SIZE - 1)) : mWidth - x;
+	}
+
+	//Get the number of pixels from row y to the end of its run along a column, GetColumnStride() pixels apart
+	inline int GetColumnRun(int y) const
+	{
+		return mLayout == TILED ? TILE_SIZE - (y & (TILE_SIZE - 1)) : mHeight - y;
+	}
+
+	inline int GetColumnStride() const
+	{
+		return mLayout == TILED ? TILE_SIZE : mPitch;
+	}
+
+	//Copy a part of a row into linear storage
+	//input:	int x, int y --- first pixel of the row
+	//			int count --- number of pixels
+	//output:	PixelRGBA *out --- receives count pixels
+	void ReadRow(int x, int y, int count, PixelRGBA *out) const;
 
 	inline PixelRGBA *GetBuffer() const 
 	{ 
 		return mColourBuffer; 
 	}
+
+	//Get a view of a rectangle of the framebuffer, the rectangle is clipped to the framebuffer
+	//input:	int x, int y --- bottom-left pixel of the rectangle
+	//			int width, int height --- size of the rectangle in pixels
+	//output:	the view, with zero width and height if the rectangle lies outside the framebuffer
+	FramebufferView GetView(int x, int y, int width, int height) const;
+
+	//Set the number of samples per pixel, 1 disables multisampling, 4 and 8 are supported
+	//Changing the sample count discards all stored samples
+	void SetSampleCount(int count);
+
+	inline int GetSampleCount() const { return mSampleCount; }
+
+	//Get the sample positions of the current sample count
+	//output:	2 * GetSampleCount() floats, the x and y offset of each sample inside a pixel in [0,1)
+	const float *GetSampleOffsets() const;
+
+	//Discard all expanded pixels, every pixel becomes a single colour again
+	void ClearSamples();
+
+	//Check if a pixel has per-sample storage
+	//input:	int index --- linear index of the pixel, see PixelIndex()
+	inline bool IsExpanded(int index) const
+	{
+		return mSampleCount > 1 && mSampleIndex[index] >= 0;
+	}
+
+	//Get the samples of a pixel, expanding the pixel from its colour if it has no per-sample storage yet
+	//input:	int index --- linear index of the pixel, see PixelIndex()
+	//output:	pointer to GetSampleCount() consecutive samples, valid until the next pixel is expanded
+	PixelRGBA *ExpandPixel(int index);
+
+	//Resolve a single expanded pixel into the colour buffer and drop its per-sample storage,
+	//used before an aliased write touches the pixel
+	//input:	int index --- linear index of the pixel, see PixelIndex()
+	void CollapsePixel(int index);
+
+	//Set every stencil value, allocating the stencil plane on first use
+	void ClearStencil(unsigned char value);
+
+	inline bool HasStencil() const { return !mStencil.empty(); }
+
+	//Get the stencil value of a pixel, the stencil plane must have been allocated by ClearStencil()
+	inline unsigned char GetStencil(int x, int y) const
+	{
+		return mStencil[y * mWidth + x];
+	}
+
+	//Set the stencil value of the pixels [x0, x1) of a row
+	void WriteStencil(int y, int x0, int x1, unsigned char value);
+
+	//Get the runs of pixels of a row whose stencil equals a value
+	//output:	the runs in increasing x, valid until the row's stencil is written or its runs are requested for another value
+	const std::vector<StencilRun> &GetStencilRuns(int y, unsigned char value);
+
+	//Average the samples of every expanded pixel into the colour buffer
+	//input:	int threads --- number of worker threads, 0 picks the number of hardware threads
+	void Resolve(int threads = 0);
 };
 
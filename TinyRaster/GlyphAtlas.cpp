@@ -0,0 +1,155 @@
+#include <math.h>
+#include <algorithm>
+
+#include "GlyphAtlas.h"
+
+//Pixels left empty between glyphs so neighbouring masks never touch
+static const int GLYPH_PADDING = 1;
+
+GlyphAtlas::GlyphAtlas(int width, int height)
+{
+	mWidth = width;
+	mHeight = height;
+	mPixels.assign((size_t)width * height, 0);
+
+	Flush();
+}
+
+void GlyphAtlas::Flush()
+{
+	mEntries.clear();
+	mShelfX = GLYPH_PADDING;
+	mShelfY = GLYPH_PADDING;
+	mShelfHeight = 0;
+}
+
+bool GlyphAtlas::Allocate(int width, int height, int &x, int &y)
+{
+	if (width + 2 * GLYPH_PADDING > mWidth || height + 2 * GLYPH_PADDING > mHeight)
+	{
+		return false;
+	}
+
+	//start a new shelf above the current one when the glyph does not fit on the right
+	if (mShelfX + width + GLYPH_PADDING > mWidth)
+	{
+		mShelfX = GLYPH_PADDING;
+		mShelfY += mShelfHeight + GLYPH_PADDING;
+		mShelfHeight = 0;
+	}
+
+	if (mShelfY + height + GLYPH_PADDING > mHeight)
+	{
+		Flush();
+	}
+
+	x = mShelfX;
+	y = mShelfY;
+
+	mShelfX += width + GLYPH_PADDING;
+	mShelfHeight = std::max(mShelfHeight, height);
+
+	return true;
+}
+
+const GlyphEntry *GlyphAtlas::GetGlyph(const Font &font, unsigned int code, float size)
+{
+	int quarterPixels = (int)(size * 4.0f + 0.5f);
+
+	if (quarterPixels <= 0)
+	{
+		return NULL;
+	}
+
+	unsigned long long key = ((unsigned long long)code << 32) | (unsigned int)quarterPixels;
+	std::unordered_map<unsigned long long, GlyphEntry>::iterator cached = mEntries.find(key);
+
+	if (cached != mEntries.end())
+	{
+		return &cached->second;
+	}
+
+	const GlyphOutline *outline = font.GetGlyph(code);
+
+	if (!outline)
+	{
+		return NULL;
+	}
+
+	float scale = quarterPixels / (4.0f * font.GetUnitsPerEm());
+	GlyphEntry entry;
+
+	entry.x = entry.y = 0;
+	entry.width = entry.height = 0;
+	entry.left = entry.bottom = 0;
+	entry.advance = outline->advance * scale;
+
+	if (!outline->points.empty())
+	{
+		float minX = outline->points[0][0];
+		float maxX = minX;
+		float minY = outline->points[0][1];
+		float maxY = minY;
+
+		for (size_t i = 1; i < outline->points.size(); i++)
+		{
+			minX = std::min(minX, outline->points[i][0]);
+			maxX = std::max(maxX, outline->points[i][0]);
+			minY = std::min(minY, outline->points[i][1]);
+			maxY = std::max(maxY, outline->points[i][1]);
+		}
+
+		int left = (int)floorf(minX * scale);
+		int bottom = (int)floorf(minY * scale);
+		int width = (int)ceilf(maxX * scale) - left;
+		int height = (int)ceilf(maxY * scale) - bottom;
+
+		if (width > 0 && height > 0 && Allocate(width, height, entry.x, entry.y))
+		{
+			mAccumulator.Reset(left, bottom, width, height);
+
+			const Vector2 *points = &outline->points[0];
+
+			for (size_t c = 0; c < outline->contourCounts.size(); c++)
+			{
+				int count = outline->contourCounts[c];
+
+				for (int i = 0; i < count; i++)
+				{
+					const Vector2 &p0 = points[i];
+					const Vector2 &p1 = points[i + 1 < count ? i + 1 : 0];
+
+					mAccumulator.AddEdge(p0[0] * scale, p0[1] * scale, p1[0] * scale, p1[1] * scale);
+				}
+
+				points += count;
+			}
+
+			mCoverage.resize(width);
+
+			for (int row = 0; row < height; row++)
+			{
+				unsigned char *pixels = &mPixels[(size_t)(entry.y + row) * mWidth + entry.x];
+				int first, last;
+
+				std::fill(pixels, pixels + width, 0);
+
+				if (mAccumulator.ResolveRow(row, false, &mCoverage[0], first, last))
+				{
+					for (int x = first; x <= last; x++)
+					{
+						pixels[x] = (unsigned char)(mCoverage[x] * 255.0f + 0.5f);
+					}
+				}
+			}
+
+			entry.width = width;
+			entry.height = height;
+			entry.left = left;
+			entry.bottom = bottom;
+		}
+	}
+
+	//Allocate may have flushed the atlas, so the entry is inserted only now
+	return &(mEntries[key] = entry);
+}
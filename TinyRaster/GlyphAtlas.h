@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "Font.h"
+#include "CoverageAccumulator.h"
+
+//Location of a rasterized glyph in the atlas
+typedef struct _GlyphEntry
+{
+	int x, y;				//bottom-left pixel of the glyph's coverage mask in the atlas
+	int width, height;		//size of the coverage mask, 0 for glyphs without outline such as space
+	int left, bottom;		//offset of the mask's bottom-left pixel from the pen position on the baseline
+	float advance;			//advance to the next pen position in pixels
+} GlyphEntry;
+
+//This class caches rasterized glyphs of a font in an 8-bit alpha atlas.
+//A glyph is rasterized with exact area coverage the first time it is requested at a size;
+//later requests return the cached coverage mask. Glyphs are packed in shelves, rows of glyphs
+//sharing a height. When the atlas is full it is flushed and filled again from scratch.
+class GlyphAtlas
+{
+private:
+	int mWidth;									//width of the atlas in pixels
+	int mHeight;								//height of the atlas in pixels
+	std::vector<unsigned char> mPixels;			//coverage of the atlas pixels, 0 to 255, bottom row first
+	int mShelfX;								//next free column on the current shelf
+	int mShelfY;								//bottom row of the current shelf
+	int mShelfHeight;							//height of the tallest glyph on the current shelf
+	std::unordered_map<unsigned long long, GlyphEntry> mEntries;	//cached glyphs by character code and size
+	CoverageAccumulator mAccumulator;			//accumulation buffer for glyph rasterisation
+	std::vector<float> mCoverage;				//scratch storage for one resolved row
+
+	//Reserve space for a mask, flushing the atlas if it is full
+	//output:	false if the mask is larger than the whole atlas
+	bool Allocate(int width, int height, int &x, int &y);
+
+public:
+	//Create an empty atlas
+	//input:	int width, int height --- size of the atlas in pixels
+	GlyphAtlas(int width = 512, int height = 512);
+
+	//Remove every cached glyph
+	void Flush();
+
+	//Get a glyph rasterized at a size, rasterizing it on first use
+	//input:	const Font &font --- the font of the glyph, an atlas must only be used with one font
+	//			unsigned int code --- character code
+	//			float size --- em size in pixels, quantised to a quarter pixel
+	//output:	the cached glyph, valid until the next call, or NULL if the font has no such glyph
+	const GlyphEntry *GetGlyph(const Font &font, unsigned int code, float size);
+
+	//Get the atlas pixels for blitting, GetWidth() pixels per row
+	inline const unsigned char *GetPixels() const { return &mPixels[0]; }
+
+	inline int GetWidth() const { return mWidth; }
+	inline int GetHeight() const { return mHeight; }
+};
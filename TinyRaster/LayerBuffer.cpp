@@ -0,0 +1,134 @@
+#include <algorithm>
+
+#include "LayerBuffer.h"
+
+LayerBuffer::LayerBuffer()
+{
+	mWidth = 0;
+	mHeight = 0;
+	mTilesPerRow = 0;
+}
+
+void LayerBuffer::Resize(int width, int height)
+{
+	mWidth = width;
+	mHeight = height;
+	mTilesPerRow = (width + TILE_SIZE - 1) / TILE_SIZE;
+	mLayers.resize((size_t)width * height);
+	mTileLayers.resize((size_t)mTilesPerRow * ((height + TILE_SIZE - 1) / TILE_SIZE));
+	mStale.resize(mTileLayers.size());
+
+	Clear();
+}
+
+void LayerBuffer::Clear()
+{
+	std::fill(mLayers.begin(), mLayers.end(), (int)EMPTY_LAYER);
+	std::fill(mTileLayers.begin(), mTileLayers.end(), (int)EMPTY_LAYER);
+	std::fill(mStale.begin(), mStale.end(), 0);
+}
+
+int LayerBuffer::TileLayer(int tileX, int tileY)
+{
+	int tile = tileY * mTilesPerRow + tileX;
+
+	if (mStale[tile])
+	{
+		int x0 = tileX << TILE_SHIFT;
+		int y0 = tileY << TILE_SHIFT;
+		int x1 = std::min(x0 + TILE_SIZE, mWidth);
+		int y1 = std::min(y0 + TILE_SIZE, mHeight);
+		int smallest = INT_MAX;
+
+		for (int y = y0; y < y1; y++)
+		{
+			const int *row = &mLayers[(size_t)y * mWidth];
+
+			for (int x = x0; x < x1; x++)
+			{
+				smallest = std::min(smallest, row[x]);
+			}
+		}
+
+		mTileLayers[tile] = smallest;
+		mStale[tile] = 0;
+	}
+
+	return mTileLayers[tile];
+}
+
+bool LayerBuffer::IsHidden(int x0, int y0, int x1, int y1, int layer)
+{
+	if (x0 >= x1 || y0 >= y1)
+	{
+		return true;
+	}
+
+	for (int tileY = y0 >> TILE_SHIFT; tileY <= (y1 - 1) >> TILE_SHIFT; tileY++)
+	{
+		for (int tileX = x0 >> TILE_SHIFT; tileX <= (x1 - 1) >> TILE_SHIFT; tileX++)
+		{
+			if (TileLayer(tileX, tileY) < layer)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int LayerBuffer::NextVisibleRun(int y, int &start, int x1, int layer)
+{
+	const int *row = &mLayers[(size_t)y * mWidth];
+	int tileY = y >> TILE_SHIFT;
+	int x = start;
+
+	//skip hidden pixels, a whole tile at a time where the tile hides the layer
+	while (x < x1)
+	{
+		if (TileLayer(x >> TILE_SHIFT, tileY) >= layer)
+		{
+			x = ((x >> TILE_SHIFT) + 1) << TILE_SHIFT;
+			continue;
+		}
+
+		if (row[x] < layer)
+		{
+			break;
+		}
+
+		x++;
+	}
+
+	start = std::min(x, x1);
+
+	while (x < x1 && row[x] < layer)
+	{
+		x++;
+	}
+
+	return std::min(x, x1);
+}
+
+void LayerBuffer::Write(int y, int x0, int x1, int layer)
+{
+	int *row = &mLayers[(size_t)y * mWidth];
+	int tileY = y >> TILE_SHIFT;
+
+	for (int x = x0; x < x1; x++)
+	{
+		row[x] = layer;
+	}
+
+	//a tile's smallest layer can only rise if it was below the written layer
+	for (int tileX = x0 >> TILE_SHIFT; x0 < x1 && tileX <= (x1 - 1) >> TILE_SHIFT; tileX++)
+	{
+		int tile = tileY * mTilesPerRow + tileX;
+
+		if (mTileLayers[tile] < layer)
+		{
+			mStale[tile] = 1;
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <limits.h>
+
+//This class stores the layer of the nearest opaque primitive covering each pixel.
+//Primitives with larger layers are nearer; a pixel is hidden from a primitive if it already holds the
+//primitive's layer or a larger one. Drawing opaque primitives front to back then skips every pixel
+//of the farther ones that is already covered.
+//
+//The buffer also keeps the smallest layer of every 8x8 tile. A tile whose smallest layer hides a primitive
+//is skipped as a whole, and a primitive whose bounds only touch such tiles is rejected before it is scanned.
+//The smallest layer of a tile is recomputed lazily, the first time the tile is tested after a write.
+class LayerBuffer
+{
+public:
+	static const int EMPTY_LAYER = INT_MIN;	//layer of a pixel no opaque primitive has covered
+	static const int TILE_SHIFT = 3;		//log2 of the tile size
+	static const int TILE_SIZE = 1 << TILE_SHIFT;	//width and height of a tile in pixels
+
+private:
+	int mWidth;							//width of the buffer in pixels
+	int mHeight;						//height of the buffer in pixels
+	int mTilesPerRow;					//number of tiles covering a row
+	std::vector<int> mLayers;			//layer per pixel, mWidth pixels per row
+	std::vector<int> mTileLayers;		//smallest layer of each tile, valid unless the tile is marked stale
+	std::vector<unsigned char> mStale;	//per tile, non-zero if a write may have raised its smallest layer
+
+	//Get the smallest layer of a tile, recomputing it if it is stale
+	int TileLayer(int tileX, int tileY);
+
+public:
+	LayerBuffer();
+
+	//Resize the buffer and reset every pixel to EMPTY_LAYER
+	void Resize(int width, int height);
+
+	//Reset every pixel to EMPTY_LAYER
+	void Clear();
+
+	//Check if every pixel of a rectangle is hidden from a layer, using the tile layers only
+	//input:	int x0, int y0, int x1, int y1 --- the pixels [x0, x1) x [y0, y1), inside the buffer
+	//			int layer --- layer of the primitive
+	//output:	true if no pixel of the rectangle is visible to the layer
+	bool IsHidden(int x0, int y0, int x1, int y1, int layer);
+
+	//Find the next run of visible pixels in a part of a row
+	//input:	int y --- row
+	//			int &start --- first pixel to search from, set to the first visible pixel
+	//			int x1 --- one past the last pixel to search
+	//			int layer --- layer of the primitive
+	//output:	one past the last pixel of the visible run starting at start, or start == x1 if no pixel is visible
+	int NextVisibleRun(int y, int &start, int x1, int layer);
+
+	//Set the layer of the pixels [x0, x1) of a row
+	void Write(int y, int x0, int x1, int layer);
+};
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <math.h>
+#include <string.h>
+#include <emmintrin.h>
+
+#include "PixelConverter.h"
+#include "TraceEvents.h"
+
+//Below this many rows per worker the conversion runs on fewer threads
+static const int CONVERT_ROWS_PER_THREAD = 64;
+
+//4x4 Bayer matrix, thresholds in [0,1) added before truncation
+static const float DITHER_THRESHOLDS[4][4] = {
+	{ 0.5f / 16.0f, 8.5f / 16.0f, 2.5f / 16.0f, 10.5f / 16.0f },
+	{ 12.5f / 16.0f, 4.5f / 16.0f, 14.5f / 16.0f, 6.5f / 16.0f },
+	{ 3.5f / 16.0f, 11.5f / 16.0f, 1.5f / 16.0f, 9.5f / 16.0f },
+	{ 15.5f / 16.0f, 7.5f / 16.0f, 13.5f / 16.0f, 5.5f / 16.0f }
+};
+
+static inline float EncodeSRGB(float linear)
+{
+	return linear <= 0.0031308f ? 12.92f * linear : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+}
+
+PixelConverter::PixelConverter(Format format, int flags)
+{
+	mFormat = format;
+	mFlags = flags;
+	mThreads = 0;
+
+	for (int i = 0; i < SRGB_TABLE_SIZE; i++)
+	{
+		mSRGBTable[i] = EncodeSRGB((float)i / (SRGB_TABLE_SIZE - 1));
+	}
+}
+
+int PixelConverter::BytesPerPixel(Format format)
+{
+	return format == RGB565 ? 2 : 4;
+}
+
+void PixelConverter::ConvertRows(const FramebufferView &view, unsigned char *dst, int dstStride, int begin, int end) const
+{
+	TRACE_SCOPE_ARG("ConvertBand", "rows", end - begin);
+
+	int width = view.width;
+	int height = view.height;
+	bool tiled = view.framebuffer && view.framebuffer->GetLayout() == Framebuffer::TILED;
+	std::vector<PixelRGBA> gathered(tiled ? width : 0);
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 scale = mFormat == RGB565 ? _mm_set_ps(0.0f, 31.0f, 63.0f, 31.0f) : _mm_set1_ps(255.0f);
+	__m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	__m128 alphaOne = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	bool premultiply = (mFlags & PREMULTIPLY) != 0;
+	bool srgb = (mFlags & SRGB) != 0;
+
+	for (int y = begin; y < end; y++)
+	{
+		const PixelRGBA *pixels = view.pixels + y * view.pitch;
+
+		//a tiled row is scattered over its tiles, it is gathered into linear storage first
+		if (tiled)
+		{
+			view.framebuffer->ReadRow(view.x, view.y + y, width, &gathered[0]);
+			pixels = &gathered[0];
+		}
+
+		const float *src = reinterpret_cast<const float*>(pixels);
+		int row = (mFlags & FLIP_ROWS) ? height - 1 - y : y;
+		unsigned char *out = dst + (size_t)row * dstStride;
+		__m128 dither[4];
+
+		//without dithering every pixel is offset by half a level, which rounds to the nearest level
+		for (int i = 0; i < 4; i++)
+		{
+			dither[i] = _mm_set1_ps((mFlags & DITHER) ? DITHER_THRESHOLDS[y & 3][i] : 0.5f);
+		}
+
+		for (int x = 0; x < width; )
+		{
+			//quantise up to four pixels, one per register
+			int count = std::min(width - x, 4);
+			__m128i levels[4];
+
+			for (int i = 0; i < count; i++)
+			{
+				__m128 colour = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + 4 * (x + i)), zero), one);
+
+				if (premultiply)
+				{
+					__m128 alpha = _mm_shuffle_ps(colour, colour, _MM_SHUFFLE(3, 3, 3, 3));
+
+					colour = _mm_mul_ps(colour, _mm_or_ps(_mm_and_ps(alpha, rgbMask), alphaOne));
+				}
+
+				if (srgb)
+				{
+					float channels[4];
+
+					_mm_storeu_ps(channels, colour);
+
+					for (int c = 0; c < 3; c++)
+					{
+						channels[c] = mSRGBTable[(int)(channels[c] * (SRGB_TABLE_SIZE - 1) + 0.5f)];
+					}
+
+					colour = _mm_loadu_ps(channels);
+				}
+
+				levels[i] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(colour, scale), dither[(x + i) & 3]));
+
+				if (mFormat == BGRA8)
+				{
+					levels[i] = _mm_shuffle_epi32(levels[i], _MM_SHUFFLE(3, 0, 1, 2));
+				}
+			}
+
+			if (mFormat == RGB565)
+			{
+				unsigned short *packed = reinterpret_cast<unsigned short*>(out) + x;
+
+				for (int i = 0; i < count; i++)
+				{
+					int channels[4];
+
+					_mm_storeu_si128((__m128i*)channels, levels[i]);
+					packed[i] = (unsigned short)((channels[0] << 11) | (channels[1] << 5) | channels[2]);
+				}
+			}
+			else if (count == 4)
+			{
+				//narrow the 16 levels to bytes in two saturating steps and store them at once
+				__m128i low = _mm_packs_epi32(levels[0], levels[1]);
+				__m128i high = _mm_packs_epi32(levels[2], levels[3]);
+
+				_mm_storeu_si128((__m128i*)(out + 4 * x), _mm_packus_epi16(low, high));
+			}
+			else
+			{
+				for (int i = 0; i < count; i++)
+				{
+					__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(levels[i], levels[i]), levels[i]);
+					int packed = _mm_cvtsi128_si32(bytes);
+
+					memcpy(out + 4 * (x + i), &packed, 4);
+				}
+			}
+
+			x += count;
+		}
+	}
+}
+
+void PixelConverter::Convert(const PixelRGBA *pixels, int width, int height, int pitch, void *dst, int dstStride) const
+{
+	FramebufferView view;
+
+	view.pixels = const_cast<PixelRGBA*>(pixels);
+	view.x = 0;
+	view.y = 0;
+	view.width = width;
+	view.height = height;
+	view.pitch = pitch;
+	view.framebuffer = NULL;
+
+	Convert(view, dst, dstStride);
+}
+
+void PixelConverter::Convert(const FramebufferView &view, void *dst, int dstStride) const
+{
+	int height = view.height;
+
+	if (view.width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	TRACE_SCOPE_ARG("Convert", "rows", height);
+
+	unsigned char *out = static_cast<unsigned char*>(dst);
+	int threads = mThreads;
+
+	if (threads <= 0)
+	{
+		threads = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+
+	threads = std::max(std::min(threads, height / CONVERT_ROWS_PER_THREAD), 1);
+
+	std::vector<std::thread> workers;
+	int chunk = (height + threads - 1) / threads;
+
+	//the calling thread converts the first band itself
+	for (int t = 1; t < threads; t++)
+	{
+		int begin = t * chunk;
+		int end = std::min(begin + chunk, height);
+
+		workers.push_back(std::thread(&PixelConverter::ConvertRows, this, std::cref(view), out, dstStride, begin, end));
+	}
+
+	ConvertRows(view, out, dstStride, 0, std::min(chunk, height));
+
+	for (size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+}
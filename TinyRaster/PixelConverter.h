@@ -0,0 +1,68 @@
+#pragma once
+
+#include "TinyRasterTypes.h"
+#include "Framebuffer.h"
+
+//This class converts float framebuffer pixels into packed 8-bit and 16-bit pixel formats.
+//Components are clamped to [0,1] and rounded to the nearest level, or dithered with a 4x4 ordered pattern.
+//The result is written straight into a caller-provided image of any row stride, large conversions
+//are split into bands of rows that are converted on several threads.
+class PixelConverter
+{
+public:
+	//enum for the packed pixel formats
+	enum Format {
+		RGBA8 = 0,					//4 bytes per pixel, red first
+		BGRA8,						//4 bytes per pixel, blue first, as used by Windows DIBs
+		RGB565						//16 bits per pixel, red in the top 5 bits, alpha dropped
+	};
+
+	//enum for the conversion options, combined as bit flags
+	enum Flags {
+		PREMULTIPLY = 1,			//multiply red, green and blue by alpha
+		SRGB = 2,					//encode red, green and blue with the sRGB transfer function, the framebuffer holds linear colours
+		DITHER = 4,					//add a 4x4 ordered dither before quantisation instead of rounding
+		FLIP_ROWS = 8				//write the top row first, the framebuffer stores the bottom row first
+	};
+
+	static const int SRGB_TABLE_SIZE = 4096;	//entries of the linear to sRGB table
+
+private:
+	Format mFormat;							//current output format
+	int mFlags;								//current combination of Flags
+	int mThreads;							//number of worker threads, 0 for the number of hardware threads
+	float mSRGBTable[SRGB_TABLE_SIZE];		//sRGB encoded values of evenly spaced linear values in [0,1]
+
+	//Convert the rows [begin, end) of a view
+	void ConvertRows(const FramebufferView &view, unsigned char *dst, int dstStride, int begin, int end) const;
+
+public:
+	PixelConverter(Format format = RGBA8, int flags = 0);
+
+	inline void SetFormat(Format format) { mFormat = format; }
+	inline Format GetFormat() const { return mFormat; }
+
+	inline void SetFlags(int flags) { mFlags = flags; }
+	inline int GetFlags() const { return mFlags; }
+
+	//Set the number of worker threads, 0 picks the number of hardware threads
+	inline void SetThreads(int threads) { mThreads = threads; }
+
+	//Get the size of one packed pixel
+	//output:	bytes per pixel of the format
+	static int BytesPerPixel(Format format);
+
+	//Convert a block of float pixels into the current format
+	//input:	const PixelRGBA *pixels --- first pixel of the bottom row
+	//			int width, int height --- size of the block in pixels
+	//			int pitch --- distance between two rows of the source in pixels
+	//			int dstStride --- distance between two rows of the destination in bytes, a multiple of BytesPerPixel()
+	//output:	void *dst --- receives height rows of width packed pixels
+	void Convert(const PixelRGBA *pixels, int width, int height, int pitch, void *dst, int dstStride) const;
+
+	//Convert the pixels of a framebuffer view into the current format
+	//input:	const FramebufferView &view --- the pixels to convert
+	//			int dstStride --- distance between two rows of the destination in bytes
+	//output:	void *dst --- receives view.height rows of view.width packed pixels
+	void Convert(const FramebufferView &view, void *dst, int dstStride) const;
+};
@@ -0,0 +1,89 @@
+#include <xmmintrin.h>
+
+#include "PixelKernels.h"
+
+static_assert(sizeof(PixelRGBA) == 4 * sizeof(float), "PixelRGBA must be four packed floats");
+
+namespace PixelKernels
+{
+	static inline __m128 LoadColour(const Colour4 &colour)
+	{
+		return _mm_loadu_ps(reinterpret_cast<const float*>(&colour));
+	}
+
+	static inline float *PixelFloats(PixelRGBA *pixel)
+	{
+		return reinterpret_cast<float*>(pixel);
+	}
+
+	//dst + (src - dst) * factor for one pixel
+	static inline void BlendPixel(PixelRGBA *dst, __m128 src, __m128 factor)
+	{
+		float *d = PixelFloats(dst);
+		__m128 current = _mm_load_ps(d);
+
+		_mm_store_ps(d, _mm_add_ps(current, _mm_mul_ps(_mm_sub_ps(src, current), factor)));
+	}
+
+	void BlendCoverage(PixelRGBA *dst, int stride, int count, const Colour4 &colour, float alpha, const float *coverage)
+	{
+		__m128 src = LoadColour(colour);
+		__m128 a = _mm_set1_ps(alpha);
+
+		for (int i = 0; i < count; i++, dst += stride)
+		{
+			BlendPixel(dst, src, _mm_mul_ps(a, _mm_set1_ps(coverage[i])));
+		}
+	}
+
+	void BlendSpan(PixelRGBA *dst, int count, const Colour4 &colour, float alpha)
+	{
+		__m128 src = LoadColour(colour);
+		__m128 factor = _mm_set1_ps(alpha);
+		int i = 0;
+
+		//two pixels per iteration to hide the load latency
+		for (; i + 2 <= count; i += 2)
+		{
+			BlendPixel(dst + i, src, factor);
+			BlendPixel(dst + i + 1, src, factor);
+		}
+
+		if (i < count)
+		{
+			BlendPixel(dst + i, src, factor);
+		}
+	}
+
+	void FillSpan(PixelRGBA *dst, int count, const Colour4 &colour)
+	{
+		__m128 src = LoadColour(colour);
+
+		for (int i = 0; i < count; i++)
+		{
+			_mm_store_ps(PixelFloats(dst + i), src);
+		}
+	}
+
+	void CopySpan(PixelRGBA *dst, const PixelRGBA *src, int count)
+	{
+		const float *s = reinterpret_cast<const float*>(src);
+
+		for (int i = 0; i < count; i++)
+		{
+			_mm_store_ps(PixelFloats(dst + i), _mm_loadu_ps(s + 4 * i));
+		}
+	}
+
+	void BlendPixels(PixelRGBA *dst, const PixelRGBA *src, int count)
+	{
+		const float *s = reinterpret_cast<const float*>(src);
+
+		for (int i = 0; i < count; i++)
+		{
+			__m128 colour = _mm_loadu_ps(s + 4 * i);
+
+			BlendPixel(dst + i, colour, _mm_shuffle_ps(colour, colour, _MM_SHUFFLE(3, 3, 3, 3)));
+		}
+	}
+}
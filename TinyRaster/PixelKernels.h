@@ -0,0 +1,32 @@
+#pragma once
+
+#include "TinyRasterTypes.h"
+
+//SSE kernels operating on runs of framebuffer pixels.
+//A PixelRGBA is four consecutive floats, so each pixel is processed as one __m128.
+//Blending follows the rasterizer's alpha blend: dst = dst + (colour - dst) * factor
+//Destination pixels must be 16 byte aligned, as every framebuffer pixel is, and are accessed with aligned loads and stores.
+//Source pixels may be unaligned.
+namespace PixelKernels
+{
+	//Blend a colour over count pixels spaced stride pixels apart
+	//input:	PixelRGBA *dst --- first destination pixel
+	//			int stride --- distance between two consecutive pixels, 1 for a row, the pitch for a column
+	//			int count --- number of pixels
+	//			const Colour4 &colour --- the colour to blend
+	//			float alpha --- blend factor applied to every pixel
+	//			const float *coverage --- per-pixel coverage in [0,1], multiplied with alpha
+	void BlendCoverage(PixelRGBA *dst, int stride, int count, const Colour4 &colour, float alpha, const float *coverage);
+
+	//Blend a colour over count consecutive pixels with a constant factor
+	void BlendSpan(PixelRGBA *dst, int count, const Colour4 &colour, float alpha);
+
+	//Store a colour into count consecutive pixels
+	void FillSpan(PixelRGBA *dst, int count, const Colour4 &colour);
+
+	//Copy count consecutive pixels, the ranges must not overlap
+	void CopySpan(PixelRGBA *dst, const PixelRGBA *src, int count);
+
+	//Blend count source pixels over consecutive pixels, each by its own alpha
+	void BlendPixels(PixelRGBA *dst, const PixelRGBA *src, int count);
+}
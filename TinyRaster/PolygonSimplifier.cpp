@@ -0,0 +1,198 @@
+#include <algorithm>
+
+#include "PolygonSimplifier.h"
+
+//Squared distance of p from the segment [a, b]
+static inline float SegmentDistanceSquared(const Vector2 &p, const Vector2 &a, const Vector2 &b)
+{
+	float dx = b[0] - a[0];
+	float dy = b[1] - a[1];
+	float px = p[0] - a[0];
+	float py = p[1] - a[1];
+	float lengthSquared = dx * dx + dy * dy;
+
+	if (lengthSquared > 0.0f)
+	{
+		float t = std::min(std::max((px * dx + py * dy) / lengthSquared, 0.0f), 1.0f);
+
+		px -= t * dx;
+		py -= t * dy;
+	}
+
+	return px * px + py * py;
+}
+
+int PolygonSimplifier::AppendTriangle(const Vertex2d* vertices, int count, std::vector<Vertex2d> &simplified)
+{
+	//the first vertex, the vertex farthest from it and the vertex farthest from the segment between them
+	const Vector2 &origin = vertices[0].position;
+	int far = 0;
+	float farDistance = 0.0f;
+
+	for (int i = 1; i < count; i++)
+	{
+		float dx = vertices[i].position[0] - origin[0];
+		float dy = vertices[i].position[1] - origin[1];
+
+		if (dx * dx + dy * dy > farDistance)
+		{
+			far = i;
+			farDistance = dx * dx + dy * dy;
+		}
+	}
+
+	int apex = 0;
+	float apexDistance = 0.0f;
+
+	for (int i = 1; i < count; i++)
+	{
+		float distance = SegmentDistanceSquared(vertices[i].position, origin, vertices[far].position);
+
+		if (distance > apexDistance)
+		{
+			apex = i;
+			apexDistance = distance;
+		}
+	}
+
+	int appended = 1;
+
+	simplified.push_back(vertices[0]);
+
+	//an empty contour is reduced to its first vertex
+	for (int i = 1; i < count; i++)
+	{
+		if ((i == far || i == apex) && farDistance > 0.0f)
+		{
+			simplified.push_back(vertices[i]);
+			appended++;
+		}
+	}
+
+	return appended;
+}
+
+int PolygonSimplifier::SimplifyContour(const Vertex2d* vertices, int count, float tolerance, std::vector<Vertex2d> &simplified)
+{
+	if (count <= 3 || tolerance <= 0.0f)
+	{
+		simplified.insert(simplified.end(), vertices, vertices + count);
+		return count;
+	}
+
+	//Vertices closer than half the tolerance to the last vertex kept are merged into it, which removes the bulk of
+	//a dense contour in one pass; Douglas-Peucker then spends the other half on the remaining vertices
+	float mergeSquared = 0.25f * tolerance * tolerance;
+	const Vector2 &origin = vertices[0].position;
+	int far = 0;
+	float farDistance = 0.0f;
+
+	mPoints.clear();
+	mPoints.push_back(0);
+
+	for (int i = 1; i < count; i++)
+	{
+		const Vector2 &last = vertices[mPoints.back()].position;
+		float dx = vertices[i].position[0] - last[0];
+		float dy = vertices[i].position[1] - last[1];
+
+		if (dx * dx + dy * dy <= mergeSquared)
+		{
+			continue;
+		}
+
+		//the contour is cut at its first vertex and the vertex farthest from it, each half is then split recursively
+		dx = vertices[i].position[0] - origin[0];
+		dy = vertices[i].position[1] - origin[1];
+
+		if (dx * dx + dy * dy > farDistance)
+		{
+			far = (int)mPoints.size();
+			farDistance = dx * dx + dy * dy;
+		}
+
+		mPoints.push_back(i);
+	}
+
+	int points = (int)mPoints.size();
+
+	if (points <= 3)
+	{
+		return AppendTriangle(vertices, count, simplified);
+	}
+
+	float splitSquared = mergeSquared;
+	int kept = 2;
+
+	mKeep.assign(points, 0);
+	mKeep[0] = 1;
+	mKeep[far] = 1;
+
+	//index points stands for the first point, closing the contour
+	mStack.clear();
+	mStack.push_back(0);
+	mStack.push_back(far);
+	mStack.push_back(far);
+	mStack.push_back(points);
+
+	//the point farthest from the cut, kept if every other point is dropped so the contour keeps an area
+	int apex = 0;
+	float apexDistance = 0.0f;
+
+	while (!mStack.empty())
+	{
+		int last = mStack.back();
+		mStack.pop_back();
+		int first = mStack.back();
+		mStack.pop_back();
+
+		const Vector2 &a = vertices[mPoints[first]].position;
+		const Vector2 &b = vertices[mPoints[last % points]].position;
+		int split = 0;
+		float splitDistance = 0.0f;
+
+		for (int p = first + 1; p < last; p++)
+		{
+			float distance = SegmentDistanceSquared(vertices[mPoints[p]].position, a, b);
+
+			if (distance > splitDistance)
+			{
+				split = p;
+				splitDistance = distance;
+			}
+		}
+
+		if (kept == 2 && splitDistance > apexDistance)
+		{
+			apex = split;
+			apexDistance = splitDistance;
+		}
+
+		if (splitDistance > splitSquared)
+		{
+			mKeep[split] = 1;
+			kept++;
+
+			mStack.push_back(first);
+			mStack.push_back(split);
+			mStack.push_back(split);
+			mStack.push_back(last);
+		}
+	}
+
+	if (kept == 2 && apex != 0)
+	{
+		mKeep[apex] = 1;
+		kept++;
+	}
+
+	for (int p = 0; p < points; p++)
+	{
+		if (mKeep[p])
+		{
+			simplified.push_back(vertices[mPoints[p]]);
+		}
+	}
+
+	return kept;
+}
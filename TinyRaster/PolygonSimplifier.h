@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include "TinyRasterTypes.h"
+
+//This class reduces the vertices of closed contours with a vertex merge followed by the Douglas-Peucker algorithm, so
+//polygons with far more vertices than the pixels they cover, e.g. coastlines seen from afar, are filled from a few
+//edges instead of thousands.
+//A vertex is dropped when the simplified outline stays within the tolerance of it; the first vertex, whose colour
+//fills the polygon, is always kept. The scratch storage is kept between calls so steady use does not allocate.
+class PolygonSimplifier
+{
+private:
+	std::vector<int> mPoints;				//vertices left by the merge, the candidates of Douglas-Peucker
+	std::vector<int> mStack;				//ranges of the contour still to be split, as pairs of vertex indices
+	std::vector<unsigned char> mKeep;		//1 for each point that is kept
+
+	//Append the largest triangle spanned from the first vertex of a contour, for contours smaller than the tolerance
+	//output:	the number of vertices appended, fewer than 3 if the contour has no area
+	int AppendTriangle(const Vertex2d* vertices, int count, std::vector<Vertex2d> &simplified);
+
+public:
+	//Append the simplified copy of a closed contour
+	//A contour that is not degenerate keeps at least 3 vertices, the vertices are appended in their original order
+	//input:	const Vertex2d* vertices --- the contour
+	//			int count --- the number of vertices of the contour
+	//			float tolerance --- largest distance between a dropped vertex and the simplified outline,
+	//			0 or less appends the contour unchanged
+	//output:	std::vector<Vertex2d> &simplified --- receives the kept vertices after its current content;
+	//			the number of vertices appended is returned
+	int SimplifyContour(const Vertex2d* vertices, int count, float tolerance, std::vector<Vertex2d> &simplified);
+};
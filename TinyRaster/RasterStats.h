@@ -0,0 +1,42 @@
+#pragma once
+
+//Per-frame instrumentation counters of the rasterizer.
+//The counters are only updated when TINYRASTER_ENABLE_STATS is defined,
+//otherwise every RASTER_STAT_* macro expands to nothing.
+
+//struct holding the counters of a single frame
+typedef struct _RasterStats
+{
+	unsigned int lines;					//number of DrawLine2D calls
+	unsigned int unfilledPolygons;		//number of DrawUnfilledPolygon2D calls
+	unsigned int filledPolygons;		//number of ScanlineFillPolygon2D calls
+	unsigned int interpolatedPolygons;	//number of ScanlineInterpolatedFillPolygon2D calls
+	unsigned int circles;				//number of DrawCircle2D calls
+	unsigned int texturedPolygons;		//number of ScanlineTexturedFillPolygon2D calls
+	unsigned int rectangles;			//number of FillRect, BlitRect and CopyRect calls
+	unsigned int spanLists;				//number of FillSpans calls
+	unsigned int shapeCacheHits;		//polygons and circles replayed from the shape cache
+	unsigned int shapeCacheMisses;		//polygons and circles captured into the shape cache
+	unsigned int occludedPrimitives;	//primitives rejected as a whole by the layer buffer
+	unsigned int culledPrimitives;		//primitives rejected as a whole by the bounds test against the clip rectangle
+	unsigned int acceptedPrimitives;	//primitives drawn without per-pixel clipping as they lie inside the clip rectangle
+	unsigned int simplifiedVertices;	//vertices dropped from filled polygons by the simplify tolerance
+
+	unsigned long long pixelsWritten;		//pixels stored to the framebuffer
+	unsigned long long pixelsBlended;		//pixels that were alpha blended with the framebuffer
+	unsigned long long pixelsRejected;		//pixels discarded by the framebuffer bounds checks
+	unsigned long long pixelsOccluded;		//pixels skipped because a nearer opaque primitive covers them
+	unsigned long long scanlines;			//scanlines processed by the fill routines
+	unsigned long long edgeIntersections;	//edge/scanline intersections computed
+	unsigned long long heapAllocations;		//heap allocations made while drawing
+} RasterStats;
+
+#ifdef TINYRASTER_ENABLE_STATS
+#define RASTER_STAT_ADD(stats, counter, n)	((stats).counter += (n))
+#define RASTER_STAT_ONLY(statement)			statement
+#else
+#define RASTER_STAT_ADD(stats, counter, n)	((void)0)
+#define RASTER_STAT_ONLY(statement)
+#endif
+
+#define RASTER_STAT_INC(stats, counter)		RASTER_STAT_ADD(stats, counter, 1)
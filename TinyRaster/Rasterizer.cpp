@@ -9,10 +9,13 @@
 ---------------------------------------------------------------------*/
 #include <algorithm>
 #include <math.h>
+#include <string.h>
 #include <iostream>
 
 #include "Rasterizer.h"
 #include "ColourUtil.h"
+#include "TraceEvents.h"
+#include "PixelKernels.h"
 
 using namespace ColourUtil;
 
@@ -33,13 +36,15 @@ void Rasterizer::ClearScanlineLUT()
 	}
 }
 
+//Outcode bits of the sides of the clip rectangle a point lies beyond
+static const unsigned int CENTRE = 0x0;
+static const unsigned int LEFT = 0x1;
+static const unsigned int RIGHT = 0x1 << 1;
+static const unsigned int BOTTOM = 0x1 << 2;
+static const unsigned int TOP = 0x1 << 3;
+
 unsigned int Rasterizer::ComputeOutCode(const Vector2 & p, const ClipRect& clipRect)
 {
-	unsigned int CENTRE = 0x0;
-	unsigned int LEFT = 0x1;
-	unsigned int RIGHT = 0x1 << 1;
-	unsigned int BOTTOM = 0x1 << 2;
-	unsigned int TOP = 0x1 << 3;
 	unsigned int outcode = CENTRE;
 	
 	if (p[0] < clipRect.left)
@@ -57,34 +62,89 @@ unsigned int Rasterizer::ComputeOutCode(const Vector2 & p, const ClipRect& clipR
 
 bool Rasterizer::ClipLine(const Vertex2d & v1, const Vertex2d & v2, const ClipRect& clipRect, Vector2 & outP1, Vector2 & outP2)
 {
-	//TODO: EXTRA This is not directly prescribed as an assignment exercise. 
-	//However, if you want to create an efficient and robust rasteriser, clipping is a usefull addition.
-	//The following code is the starting point of the Cohen-Sutherland clipping algorithm.
-	//If you complete its implementation, you can test it by calling prior to calling any DrawLine2D .
-
-	const Vector2 p1 = v1.position;
-	const Vector2 p2 = v2.position;
+	//Cohen-Sutherland: an end point outside the rectangle is moved along the line onto a side it lies beyond
+	//until both end points are inside, or both lie beyond the same side and the line is rejected
+	Vector2 p1 = v1.position;
+	Vector2 p2 = v2.position;
 	unsigned int outcode1 = ComputeOutCode(p1, clipRect);
 	unsigned int outcode2 = ComputeOutCode(p2, clipRect);
 
+	//the right and top sides are exclusive, points are moved onto the last column and row inside them
+	float left = (float)clipRect.left;
+	float right = (float)(clipRect.right - 1);
+	float bottom = (float)clipRect.bottom;
+	float top = (float)(clipRect.top - 1);
+
+	//every pass clears a side of one end point, rounding can only leave a point a fraction outside after four
+	for (int pass = 0; pass < 8 && (outcode1 | outcode2); pass++) {
+		if (outcode1 & outcode2) {
+			return false;
+		}
+
+		unsigned int outcode = outcode1 ? outcode1 : outcode2;
+		Vector2 p;
+
+		if (outcode & TOP) {
+			p = Vector2(p1[0] + (p2[0] - p1[0]) * (top - p1[1]) / (p2[1] - p1[1]), top);
+		}
+		else if (outcode & BOTTOM) {
+			p = Vector2(p1[0] + (p2[0] - p1[0]) * (bottom - p1[1]) / (p2[1] - p1[1]), bottom);
+		}
+		else if (outcode & RIGHT) {
+			p = Vector2(right, p1[1] + (p2[1] - p1[1]) * (right - p1[0]) / (p2[0] - p1[0]));
+		}
+		else {
+			p = Vector2(left, p1[1] + (p2[1] - p1[1]) * (left - p1[0]) / (p2[0] - p1[0]));
+		}
+
+		if (outcode == outcode1) {
+			p1 = p;
+			outcode1 = ComputeOutCode(p1, clipRect);
+		}
+		else {
+			p2 = p;
+			outcode2 = ComputeOutCode(p2, clipRect);
+		}
+	}
+
 	outP1 = p1;
 	outP2 = p2;
-	
-	bool draw = false;
 
-	return true;
+	return (outcode1 & outcode2) == 0;
 }
 
 void Rasterizer::WriteRGBAToFramebuffer(int x, int y, const Colour4 & colour)
 {
-	if (x >= mWidth || y >= mHeight)
+	if (!mInsideClip && (x < 0 || y < 0 || x >= mWidth || y >= mHeight || (!mCapture && IsMasked(x, y))))
+	{
+		RASTER_STAT_INC(mStats, pixelsRejected);
+		return;
+	}
+
+	if (mCapture)
+	{
+		mCapture->Add(y, x, x + 1);
+		return;
+	}
+
+	if (mStencilMode == STENCIL_WRITE)
 	{
+		mFramebuffer->WriteStencil(y, x, x + 1, mStencilValue);
 		return;
 	}
 
 	PixelRGBA *pixel = mFramebuffer->GetBuffer();
+	int index = mFramebuffer->PixelIndex(x, y);
+
+	//an aliased write covers every sample of a multisampled pixel
+	if (mFramebuffer->IsExpanded(index))
+	{
+		mFramebuffer->CollapsePixel(index);
+	}
 	
-	pixel[y*mWidth + x] = colour;
+	pixel[index] = colour;
+
+	RASTER_STAT_INC(mStats, pixelsWritten);
 }
 
 Rasterizer::Rasterizer(int width, int height)
@@ -94,6 +154,7 @@ Rasterizer::Rasterizer(int width, int height)
 	mScanlineLUT = new Scanline[height];
 	mWidth = width;
 	mHeight = height;
+	mPitch = mFramebuffer->GetPitch();
 
 	mBGColour.SetVector(0.0, 0.0, 0.0, 1.0);	//default bg colour is black
 	mFGColour.SetVector(1.0, 1.0, 1.0, 1.0);    //default fg colour is white
@@ -101,8 +162,23 @@ Rasterizer::Rasterizer(int width, int height)
 	mGeometryMode = LINE;
 	mFillMode = UNFILLED;
 	mBlendMode = NO_BLEND;
+	mAntialiasMode = NO_ANTIALIAS;
+	mFillRule = EVEN_ODD;
+	mOcclusionMode = NO_OCCLUSION;
+	mLayer = 0;
+	mStencilMode = NO_STENCIL;
+	mStencilValue = 0;
+	mCapture = NULL;
+	mNextEdge = 0;
+	mTexture = NULL;
+	mIdentityTransform = true;
+	mSimplifyTolerance = 0.0f;
+	mInsideClip = false;
 
 	SetClipRectangle(0, mWidth, 0, mHeight);
+
+	memset(&mStats, 0, sizeof(RasterStats));
+	memset(&mLastFrameStats, 0, sizeof(RasterStats));
 }
 
 Rasterizer::~Rasterizer()
@@ -113,42 +189,366 @@ Rasterizer::~Rasterizer()
 
 void Rasterizer::Clear(const Colour4& colour)
 {
+	TRACE_SCOPE("Clear");
+
 	PixelRGBA *pixel = mFramebuffer->GetBuffer();
 
 	SetBGColour(colour);
 
-	int size = mWidth*mHeight;
-	
-	for(int i = 0; i < size; i++)
+	//clearing the framebuffer starts a new frame
+	mLastFrameStats = mStats;
+	memset(&mStats, 0, sizeof(RasterStats));
+
+	mFramebuffer->ClearSamples();
+
+	if (mOcclusionMode == LAYER_OCCLUSION) {
+		mLayerBuffer.Clear();
+	}
+
+	//fill all pixels in the framebuffer with background colour, the padding included so the
+	//whole buffer is one contiguous run in either layout
+	PixelKernels::FillSpan(pixel, mFramebuffer->GetBufferSize(), mBGColour);
+}
+
+//Pixels a primitive may reach past the bounds of its positions through coordinate truncation, anti-aliased edges
+//and sample offsets, so the bounds test never rejects a drawn pixel or accepts one that needs clipping
+static const float CULL_MARGIN = 2.0f;
+
+//Get the bounds of the positions of count vertices, count must be at least 1
+static void GetPositionBounds(const Vertex2d *vertices, int count, float &minX, float &maxX, float &minY, float &maxY)
+{
+	minX = maxX = vertices[0].position[0];
+	minY = maxY = vertices[0].position[1];
+
+	for (int i = 1; i < count; i++) {
+		minX = std::min(minX, vertices[i].position[0]);
+		maxX = std::max(maxX, vertices[i].position[0]);
+		minY = std::min(minY, vertices[i].position[1]);
+		maxY = std::max(maxY, vertices[i].position[1]);
+	}
+}
+
+//Sets the trivial accept flag for the primitive being drawn and restores it on every return,
+//so a primitive drawn from inside another, e.g. the spans replayed by the shape cache, keeps the outer flag
+class InsideClipScope
+{
+private:
+	bool &mInside;
+	bool mPrevious;
+
+public:
+	InsideClipScope(bool &inside, bool accepted) : mInside(inside), mPrevious(inside)
+	{
+		mInside = accepted;
+	}
+
+	~InsideClipScope()
 	{
-		//fill all pixels in the framebuffer with background colour
-		*(pixel + i) = mBGColour;
+		mInside = mPrevious;
+	}
+};
+
+Rasterizer::ClipResult Rasterizer::ClassifyBounds(float minX, float maxX, float minY, float maxY, float margin)
+{
+	// A capture records every pixel inside the framebuffer, whatever the clip rectangle
+	int left = mCapture ? 0 : std::max(mClipRect.left, 0);
+	int right = mCapture ? mWidth : std::min(mClipRect.right, mWidth);
+	int bottom = mCapture ? 0 : std::max(mClipRect.bottom, 0);
+	int top = mCapture ? mHeight : std::min(mClipRect.top, mHeight);
+
+	if (left >= right || bottom >= top ||
+		maxX + margin < left || minX - margin >= right || maxY + margin < bottom || minY - margin >= top) {
+		RASTER_STAT_INC(mStats, culledPrimitives);
+		return CLIP_OUTSIDE;
+	}
+
+	if (mStencilMode != STENCIL_TEST &&
+		minX - margin >= left && maxX + margin < right && minY - margin >= bottom && maxY + margin < top) {
+		RASTER_STAT_INC(mStats, acceptedPrimitives);
+		return CLIP_INSIDE;
+	}
+
+	return CLIP_PARTIAL;
+}
+
+void Rasterizer::GetClipRows(int & bottom, int & top) const
+{
+	bottom = mCapture ? 0 : std::max(mClipRect.bottom, 0);
+	top = mCapture ? mHeight : std::min(mClipRect.top, mHeight);
+}
+
+const Vertex2d* Rasterizer::TransformVertices(const Vertex2d * vertices, int count)
+{
+	if (mIdentityTransform || count <= 0) {
+		return vertices;
 	}
+
+	// The scratch array only grows, so steady frames transform without allocating
+	if ((int)mTransformedVertices.size() < count) {
+		mTransformedVertices.resize(count);
+		RASTER_STAT_INC(mStats, heapAllocations);
+	}
+
+	mTransform.Apply(vertices, &mTransformedVertices[0], count);
+
+	return &mTransformedVertices[0];
+}
+
+const Vertex2d* Rasterizer::SimplifyContours(const Vertex2d * vertices, const int *& contourCounts, int contourCount, int & count)
+{
+	size_t capacity = mSimplifiedVertices.capacity() + mSimplifiedCounts.capacity();
+
+	mSimplifiedVertices.clear();
+	mSimplifiedCounts.clear();
+
+	for (int c = 0; c < contourCount; c++) {
+		mSimplifiedCounts.push_back(mSimplifier.SimplifyContour(vertices, contourCounts[c], mSimplifyTolerance, mSimplifiedVertices));
+		vertices += contourCounts[c];
+	}
+
+	if (mSimplifiedVertices.capacity() + mSimplifiedCounts.capacity() != capacity) {
+		RASTER_STAT_INC(mStats, heapAllocations);
+	}
+
+	RASTER_STAT_ADD(mStats, simplifiedVertices, count - (int)mSimplifiedVertices.size());
+
+	count = (int)mSimplifiedVertices.size();
+	contourCounts = &mSimplifiedCounts[0];
+
+	return &mSimplifiedVertices[0];
 }
 
 void Rasterizer::DrawPoint2D(const Vector2& pt, int size)
 {
-	int x = pt[0];
-	int y = pt[1];
+	PlotPoint2D(mIdentityTransform ? pt : mTransform.Apply(pt));
+}
+
+void Rasterizer::PlotPoint2D(const Vector2& pt)
+{
+	//round down, truncation would fold points just left of or below the framebuffer onto its first column or row
+	int x = (int)floorf(pt[0]);
+	int y = (int)floorf(pt[1]);
 	
-	if (x < 0 || y < 0) { return; }
+	//reject points outside the framebuffer, the clip rectangle or the stencil before the blend reads the destination pixel
+	if (!mInsideClip && (x < 0 || y < 0 || x >= mWidth || y >= mHeight || (!mCapture && IsMasked(x, y)))) {
+		RASTER_STAT_INC(mStats, pixelsRejected);
+		return;
+	}
 
-	if (mBlendMode == Rasterizer::NO_BLEND) {
+	//a point captured or written into the stencil leaves the colour and the samples of its pixel untouched
+	if (mBlendMode == Rasterizer::NO_BLEND || mCapture || mStencilMode == STENCIL_WRITE) {
 		WriteRGBAToFramebuffer(x, y, mFGColour);
 	}
 	else if (mBlendMode == Rasterizer::ALPHA_BLEND) {
+		RASTER_STAT_INC(mStats, pixelsBlended);
+
+
 		// Retrieve current colour of frame buffer at location
 
 		PixelRGBA *pixel = mFramebuffer->GetBuffer();
-		Colour4 c = pixel[y*mWidth + x];
+
+		int index = mFramebuffer->PixelIndex(x, y);
+
+		if (mFramebuffer->IsExpanded(index)) {
+			mFramebuffer->CollapsePixel(index);
+		}
+
+		Colour4 c = pixel[index];
 
 		// Write the interpolated alpha blend with the two colours instead
 		WriteRGBAToFramebuffer(x, y, ColourUtil::Interpolate(c, mFGColour, mFGColour[3]));
 	}
 }
 
-void Rasterizer::DrawLine2D(const Vertex2d & v1, const Vertex2d & v2, int thickness)
+void Rasterizer::DrawLine2D(const Vertex2d & inV1, const Vertex2d & inV2, int thickness)
+{
+	TRACE_SCOPE_ARG("DrawLine2D", "thickness", thickness);
+	RASTER_STAT_INC(mStats, lines);
+
+	Vertex2d ends[2] = { inV1, inV2 };
+
+	if (!mIdentityTransform) {
+		mTransform.Apply(ends, ends, 2);
+	}
+
+	const Vertex2d &v1 = ends[0];
+	const Vertex2d &v2 = ends[1];
+
+	ClipResult clip = ClassifyBounds(std::min(v1.position[0], v2.position[0]), std::max(v1.position[0], v2.position[0]),
+		std::min(v1.position[1], v2.position[1]), std::max(v1.position[1], v2.position[1]), thickness + CULL_MARGIN);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
+	if (mAntialiasMode == ANALYTIC_ANTIALIAS) {
+		RasterizeAntialiasedLine2D(v1, v2, thickness);
+	}
+	else if (mAntialiasMode == MULTISAMPLE_ANTIALIAS) {
+		// Fill the line's rectangle, line end points are pixel centres so shift them into the area convention
+		// and extend the rectangle by half a pixel at both ends like the anti-aliased line's caps
+		Vector2 p0 = v1.position + Vector2(0.5f, 0.5f);
+		Vector2 p1 = v2.position + Vector2(0.5f, 0.5f);
+		Vector2 dir = p1 - p0;
+		float length = dir.Norm();
+
+		dir = length > 0.0f ? dir * (0.5f / length) : Vector2(0.5f, 0.0f);
+
+		Vector2 normal = Vector2(-dir[1], dir[0]) * (float)std::max(thickness, 1);
+		Vertex2d quad[4] = {
+			{ v1.colour, p0 - dir - normal },
+			{ v1.colour, p1 + dir - normal },
+			{ v1.colour, p1 + dir + normal },
+			{ v1.colour, p0 - dir + normal }
+		};
+		Vertex2d gradient[2] = { { v1.colour, p0 }, { v2.colour, p1 } };
+
+		int quadCount = 4;
+
+		MultisampleFillPolygon2D(quad, &quadCount, 1, mFillMode == Rasterizer::INTERPOLATED_FILLED ? gradient : NULL);
+	}
+	else {
+		RasterizeLine2D(v1, v2, thickness);
+	}
+}
+
+void Rasterizer::RasterizeAntialiasedLine2D(const Vertex2d & v1, const Vertex2d & v2, int thickness)
+{
+	float x0 = v1.position[0];
+	float y0 = v1.position[1];
+	float x1 = v2.position[0];
+	float y1 = v2.position[1];
+	Colour4 c0 = v1.colour;
+	Colour4 c1 = mFillMode == Rasterizer::INTERPOLATED_FILLED ? v2.colour : v1.colour;
+
+	// Walk along the major axis, for steep lines x and y are swapped
+	bool steep = fabsf(y1 - y0) > fabsf(x1 - x0);
+
+	if (steep) {
+		std::swap(x0, y0);
+		std::swap(x1, y1);
+	}
+
+	if (x1 < x0) {
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+		std::swap(c0, c1);
+	}
+
+	float length = x1 - x0;
+	float gradient = length > 0.0f ? (y1 - y0) / length : 0.0f;
+
+	// Half the extent of the line's cross-section measured along the minor axis
+	float halfExtent = 0.5f * std::max(thickness, 1) * sqrtf(1.0f + gradient * gradient);
+
+	int majorSize = steep ? mHeight : mWidth;
+	int minorSize = steep ? mWidth : mHeight;
+
+	// The line covers [x0 - 0.5, x1 + 0.5] so integer end points are fully covered, as in RasterizeLine2D
+	int start = std::max((int)floorf(x0), 0);
+	int end = std::min((int)ceilf(x1), majorSize - 1);
+
+	for (int x = start; x <= end; x++) {
+		float majorCoverage = std::min(x + 0.5f, x1 + 0.5f) - std::max(x - 0.5f, x0 - 0.5f);
+
+		if (majorCoverage <= 0.0f) {
+			continue;
+		}
+
+		majorCoverage = std::min(majorCoverage, 1.0f);
+
+		float centre = y0 + gradient * (x - x0);
+		float bottom = centre - halfExtent;
+		float top = centre + halfExtent;
+		int minorStart = std::max((int)floorf(bottom + 0.5f), 0);
+		int minorEnd = std::min((int)floorf(top + 0.5f), minorSize - 1);
+		int count = minorEnd - minorStart + 1;
+
+		if (count <= 0) {
+			continue;
+		}
+
+		if ((int)mCoverage.size() < count) {
+			mCoverage.resize(count);
+			RASTER_STAT_INC(mStats, heapAllocations);
+		}
+
+		for (int y = minorStart; y <= minorEnd; y++) {
+			mCoverage[y - minorStart] = majorCoverage * (std::min(y + 0.5f, top) - std::max(y - 0.5f, bottom));
+		}
+
+		Colour4 colour = c0;
+
+		if (length > 0.0f && mFillMode == Rasterizer::INTERPOLATED_FILLED) {
+			colour = ColourUtil::Interpolate(c0, c1, std::min(std::max((x - x0) / length, 0.0f), 1.0f));
+		}
+
+		float alpha = mBlendMode == Rasterizer::ALPHA_BLEND ? colour[3] : 1.0f;
+
+		if (mCapture) {
+			for (int i = 0; i < count && !steep; i++) {
+				mCapture->Add(minorStart + i, x, x + 1, mCoverage[i]);
+			}
+
+			if (steep) {
+				mCapture->AddCoverageRow(minorStart, x, &mCoverage[0], count);
+			}
+
+			continue;
+		}
+
+		if (IsMaskActive()) {
+			for (int i = 0; i < count; i++) {
+				if (steep ? IsMasked(minorStart + i, x) : IsMasked(x, minorStart + i)) {
+					mCoverage[i] = 0.0f;
+				}
+			}
+		}
+
+		// Covered multisampled pixels are collapsed before the coverage blend, as the aliased spans do
+		for (int i = 0; i < count; i++) {
+			int px = steep ? minorStart + i : x;
+
+			if (mCoverage[i] > 0.0f) {
+				CollapseSamples(steep ? x : minorStart + i, px, px + 1);
+			}
+		}
+
+		// A steep line covers part of a row, a shallow one part of a column
+		if (steep) {
+			BlendCoverageRun(minorStart, x, count, false, colour, alpha, &mCoverage[0]);
+		}
+		else {
+			BlendCoverageRun(x, minorStart, count, true, colour, alpha, &mCoverage[0]);
+		}
+	}
+}
+
+void Rasterizer::RasterizeLine2D(const Vertex2d & inV1, const Vertex2d & inV2, int thickness)
 {
+	Vertex2d v1 = inV1;
+	Vertex2d v2 = inV2;
+
+	// A line leaving the framebuffer is cut to it before it is stepped, so its off-screen pixels are never visited.
+	// The cut does not use the clip rectangle, which would move the stepped pixels with every damage rectangle or tile.
+	if (!mInsideClip) {
+		int margin = std::max(thickness, 1) + 2;
+		ClipRect bounds = { -margin, mWidth + margin, mHeight + margin, -margin };
+		float length = (inV2.position - inV1.position).Norm();
+
+		if (!ClipLine(inV1, inV2, bounds, v1.position, v2.position)) {
+			return;
+		}
+
+		// The colours at the cut end points keep the gradient of the whole line
+		if (length > 0.0f) {
+			v1.colour = ColourUtil::Interpolate(inV1.colour, inV2.colour, (v1.position - inV1.position).Norm() / length);
+			v2.colour = ColourUtil::Interpolate(inV1.colour, inV2.colour, (v2.position - inV1.position).Norm() / length);
+		}
+	}
+
 	Vector2 pt1 = v1.position;
 	Vector2 pt2 = v2.position;
 
@@ -162,9 +562,10 @@ void Rasterizer::DrawLine2D(const Vertex2d & v1, const Vertex2d & v2, int thickn
 	bool swap_xy = dy*reflect > dx;
 	int epsilon = 0;
 
-	int sx = swap_xy ? reflect < 0 ? swap_x ? pt1[1] : pt2[1] : swap_x ? pt2[1] : pt1[1] : swap_x ? pt2[0] : pt1[0];
-	int sy = swap_xy ? reflect < 0 ? swap_x ? pt1[0] : pt2[0] : swap_x ? pt2[0] : pt1[0] : swap_x ? pt2[1] : pt1[1];
-	int ex = swap_xy ? reflect < 0 ? swap_x ? pt2[1] : pt1[1] : swap_x ? pt1[1] : pt2[1] : swap_x ? pt1[0] : pt2[0];
+	// End points are rounded down, so a line moved by whole pixels covers the same pixels on either side of the origin
+	int sx = (int)floorf(swap_xy ? reflect < 0 ? swap_x ? pt1[1] : pt2[1] : swap_x ? pt2[1] : pt1[1] : swap_x ? pt2[0] : pt1[0]);
+	int sy = (int)floorf(swap_xy ? reflect < 0 ? swap_x ? pt1[0] : pt2[0] : swap_x ? pt2[0] : pt1[0] : swap_x ? pt2[1] : pt1[1]);
+	int ex = (int)floorf(swap_xy ? reflect < 0 ? swap_x ? pt2[1] : pt1[1] : swap_x ? pt1[1] : pt2[1] : swap_x ? pt1[0] : pt2[0]);
 
 	int y = sy;
 	int x = sx;
@@ -202,7 +603,7 @@ void Rasterizer::DrawLine2D(const Vertex2d & v1, const Vertex2d & v2, int thickn
 		}
 
 		SetFGColour(colour);
-		DrawPoint2D(temp);
+		PlotPoint2D(temp);
 
 		// Line thickness
 		if (thickness > 1) {
@@ -220,13 +621,13 @@ void Rasterizer::DrawLine2D(const Vertex2d & v1, const Vertex2d & v2, int thickn
 					int newX = temp[0] - tx;
 
 					Vector2 temp2(newX, newY);
-					DrawPoint2D(temp2);
+					PlotPoint2D(temp2);
 
 					newY = temp[1] + ty;
 					newX = temp[0] + tx;
 
 					Vector2 temp3(newX, newY);
-					DrawPoint2D(temp3);
+					PlotPoint2D(temp3);
 				}
 				else {
 
@@ -234,13 +635,13 @@ void Rasterizer::DrawLine2D(const Vertex2d & v1, const Vertex2d & v2, int thickn
 					int newX = temp[0] + tx;
 
 					Vector2 temp2(newX, newY);
-					DrawPoint2D(temp2);
+					PlotPoint2D(temp2);
 
 					newY = temp[1] - ty;
 					newX = temp[0] - tx;
 
 					Vector2 temp3(newX, newY);
-					DrawPoint2D(temp3);
+					PlotPoint2D(temp3);
 				}
 				
 			}
@@ -260,11 +661,44 @@ void Rasterizer::DrawLine2D(const Vertex2d & v1, const Vertex2d & v2, int thickn
 
 void Rasterizer::DrawUnfilledPolygon2D(const Vertex2d * vertices, int count)
 {
+	TRACE_SCOPE_ARG("DrawUnfilledPolygon2D", "vertices", count);
+	RASTER_STAT_INC(mStats, unfilledPolygons);
+
+	if (count <= 0) {
+		return;
+	}
+
+	vertices = TransformVertices(vertices, count);
+
+	// One bounds test covers every edge of the outline
+	float minX, maxX, minY, maxY;
+
+	GetPositionBounds(vertices, count, minX, maxX, minY, maxY);
+
+	ClipResult clip = ClassifyBounds(minX, maxX, minY, maxY, CULL_MARGIN);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
 	for (int i = 0; i < count - 1; i++) {
-		DrawLine2D(vertices[i], vertices[i + 1]);
+		RasterizeLine2D(vertices[i], vertices[i + 1], 1);
 	}
 
-	DrawLine2D(vertices[0], vertices[count - 1]);
+	RasterizeLine2D(vertices[0], vertices[count - 1], 1);
+}
+
+//Append an edge intersection to a scanline, counting any reallocation of its storage
+static inline void PushScanlineItem(Scanline *scanline, const ScanlineLUTItem &item, RasterStats &stats)
+{
+	RASTER_STAT_ONLY(size_t capacity = scanline->capacity());
+
+	scanline->push_back(item);
+
+	RASTER_STAT_ADD(stats, edgeIntersections, 1);
+	RASTER_STAT_ADD(stats, heapAllocations, scanline->capacity() != capacity ? 1 : 0);
 }
 
 struct less_than_key
@@ -275,6 +709,30 @@ struct less_than_key
 	}
 };
 
+struct crossing_less_than_key
+{
+	inline bool operator() (const SampleCrossing& crossing1, const SampleCrossing& crossing2)
+	{
+		return (crossing1.x < crossing2.x);
+	}
+};
+
+struct edge_less_than_key
+{
+	inline bool operator() (const EdgeBucket& edge1, const EdgeBucket& edge2)
+	{
+		return (edge1.yMin < edge2.yMin);
+	}
+};
+
+struct run_ends_before_key
+{
+	inline bool operator() (const StencilRun& run, int x)
+	{
+		return (run.x1 <= x);
+	}
+};
+
 void Rasterizer::ScanlineFillPolygon2D(const Vertex2d * vertices, int count)
 {
 	//TODO:
@@ -289,96 +747,1052 @@ void Rasterizer::ScanlineFillPolygon2D(const Vertex2d * vertices, int count)
 	//Note: The variable mBlendMode indicates if the blend mode is set to alpha blending.
 	//To do alpha blending during filling, the new colour of a point should be combined with the existing colour in the framebuffer using the alpha value.
 	//Use Test 6 (Press F6) to test your solution
-	
-	int minShapeY = INT_MAX;
-	int maxShapeY = INT_MIN;
-	int minShapeX = INT_MAX;
-	int maxShapeX = INT_MIN;
 
-	SetFGColour(vertices[0].colour);
+	ScanlineFillPolygon2D(vertices, &count, 1);
+}
 
-	for (int i = 0; i < count; i++) {
-		if (minShapeY > vertices[i].position[1]) {
-			minShapeY = vertices[i].position[1];
-		}
-		else if (maxShapeY < vertices[i].position[1]) {
-			maxShapeY = vertices[i].position[1];
-		}
+//Check if a polygon is an axis-aligned rectangle with the given bounds
+static bool IsAxisAlignedRectangle(const Vertex2d *vertices, int count, float minX, float maxX, float minY, float maxY)
+{
+	if (count != 4) {
+		return false;
+	}
 
-		if (minShapeX > vertices[i].position[0]) {
-			minShapeX = vertices[i].position[0];
-		}
-		else if (maxShapeX < vertices[i].position[0]) {
-			maxShapeX = vertices[i].position[0];
+	for (int i = 0; i < 4; i++) {
+		const Vector2 &a = vertices[i].position;
+		const Vector2 &b = vertices[(i + 1) & 3].position;
+
+		if (!(a[0] == minX || a[0] == maxX) || !(a[1] == minY || a[1] == maxY) || (a[0] == b[0]) == (a[1] == b[1])) {
+			return false;
 		}
 	}
 
-	ScanlineLUTItem l;
-	Vector2 point;
+	return true;
+}
 
-	for (int y = minShapeY; y < maxShapeY; y++) {
-		if (y < 0) { y = 0;  continue; }
+static inline int CountContourVertices(const int *contourCounts, int contourCount)
+{
+	int count = 0;
 
-		std::vector<ScanlineLUTItem> *lutTable = new std::vector<ScanlineLUTItem>;
+	for (int c = 0; c < contourCount; c++) {
+		count += contourCounts[c];
+	}
 
-		for (int v = 0; v < count;) {
-			Vector2 v1 = vertices[v++].position;
-			Vector2 v2;
-			
-			if (v == count) {
-				v2 = vertices[0].position;
-			}
-			else {
-				v2 = vertices[v].position;
-			}
-			
-			
-			if((y >= v1[1] && y < v2[1]) || (y >= v2[1] && y < v1[1])){
-				int x = v1[0] + (y - v1[1]) * ((v1[0] - v2[0]) / (v1[1] - v2[1]));
+	return count;
+}
 
-				l.colour = Colour4();
-				l.pos_x = x;
-				lutTable->push_back(l);
-			}
-		}
+static inline void GetVertexBounds(const Vertex2d *vertices, int count, float &minX, float &maxX, float &minY, float &maxY)
+{
+	minX = maxX = vertices[0].position[0];
+	minY = maxY = vertices[0].position[1];
+
+	for (int i = 1; i < count; i++) {
+		minX = std::min(minX, vertices[i].position[0]);
+		maxX = std::max(maxX, vertices[i].position[0]);
+		minY = std::min(minY, vertices[i].position[1]);
+		maxY = std::max(maxY, vertices[i].position[1]);
+	}
+}
 
-		std::sort(lutTable->begin(), lutTable->end(), less_than_key());
+void Rasterizer::ScanlineFillPolygon2D(const Vertex2d * vertices, const int * contourCounts, int contourCount)
+{
+	int count = CountContourVertices(contourCounts, contourCount);
 
-		if (lutTable->size() != 0)
-		{
-			bool draw = true;
+	TRACE_SCOPE_ARG("ScanlineFillPolygon2D", "vertices", count);
+	RASTER_STAT_INC(mStats, filledPolygons);
 
-			for (int i = 0; i < lutTable->size() - 1;)
-			{
-				int start = lutTable->at(i++).pos_x;
-				int end = lutTable->at(i).pos_x;
+	if (count == 0) {
+		return;
+	}
 
-				if (draw) {
-					if (start > end) {
-						int temp = start;
-						start = end;
-						end = temp;
-					}
+	vertices = TransformVertices(vertices, count);
 
-					while (start < end)
-					{
-						if (start > 0 && y > 0) {
-							point[0] = start;
-							point[1] = y;
+	// Shapes are rendered into the stencil with the aliased fill
+	bool aliased = mAntialiasMode == NO_ANTIALIAS || mStencilMode == STENCIL_WRITE;
 
-							DrawPoint2D(point);
-						}
+	if (aliased) {
+		SetFGColour(vertices[0].colour);
+	}
+
+	float minX, maxX, minY, maxY;
+
+	GetVertexBounds(vertices, count, minX, maxX, minY, maxY);
+
+	ClipResult clip = ClassifyBounds(minX, maxX, minY, maxY, CULL_MARGIN);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
+	if (aliased && IsOccluded(minX, maxX, minY, maxY)) {
+		return;
+	}
+
+	// Only polygons that survive the cull are simplified, and only contours with vertices to spare. The simplified
+	// contours keep a subset of the vertices, so the classification above still holds for them.
+	if (mSimplifyTolerance > 0.0f && count > 3 * contourCount) {
+		vertices = SimplifyContours(vertices, contourCounts, contourCount, count);
+
+		GetVertexBounds(vertices, count, minX, maxX, minY, maxY);
+	}
+
+	// Axis-aligned rectangles, common in UI, are filled row by row without an edge table
+	if (aliased && contourCount == 1 && IsAxisAlignedRectangle(vertices, count, minX, maxX, minY, maxY)) {
+		WriteRect(std::max((int)ceilf(minX - 0.5f), 0), std::max((int)ceilf(minY - 0.5f), 0),
+			std::min((int)ceilf(maxX - 0.5f), mWidth), std::min((int)ceilf(maxY - 0.5f), mHeight), vertices[0].colour);
+		return;
+	}
+
+	if (!FillCachedPolygon(vertices, contourCounts, contourCount, minX, maxX, minY, maxY)) {
+		RasterizePolygon(vertices, contourCounts, contourCount, minX, maxX, minY, maxY);
+	}
+}
+
+void Rasterizer::RasterizePolygon(const Vertex2d * vertices, const int * contourCounts, int contourCount, float minX, float maxX, float minY, float maxY)
+{
+	if (mAntialiasMode == ANALYTIC_ANTIALIAS && mStencilMode != STENCIL_WRITE) {
+		AntialiasedFillPolygon2D(vertices, contourCounts, contourCount);
+	}
+	else if (mAntialiasMode == MULTISAMPLE_ANTIALIAS && mStencilMode != STENCIL_WRITE) {
+		MultisampleFillPolygon2D(vertices, contourCounts, contourCount, NULL);
+	}
+	else {
+		BuildEdgeTable(vertices, contourCounts, contourCount);
+		FillEdgeTable(minY, maxY, vertices[0].colour, NULL);
+	}
+}
+
+bool Rasterizer::FillCachedPolygon(const Vertex2d * vertices, const int * contourCounts, int contourCount, float minX, float maxX, float minY, float maxY)
+{
+	bool aliased = mAntialiasMode == NO_ANTIALIAS || mStencilMode == STENCIL_WRITE;
+
+	// Polygons are cached whole and clipped by FillSpans at replay, so only those larger than the framebuffer
+	// cannot be held. Multisampled fills keep per-sample coverage that spans cannot hold, and the anti-aliased
+	// fills bypass the occlusion test that replayed spans would take.
+	if (mShapeCache.GetCapacity() == 0 || mCapture || (!aliased && (mAntialiasMode == MULTISAMPLE_ANTIALIAS || mOcclusionMode != NO_OCCLUSION)) ||
+		maxX - floorf(minX) > mWidth || maxY - floorf(minY) > mHeight) {
+		return false;
+	}
+
+	int originX = (int)floorf(minX);
+	int originY = (int)floorf(minY);
+	int count = CountContourVertices(contourCounts, contourCount);
+
+	// The key holds the fill path and rule, the contours and the positions relative to the origin
+	mShapeKey.clear();
+	mShapeKey.push_back((float)POLYGON_SHAPE);
+	mShapeKey.push_back((float)(aliased ? NO_ANTIALIAS : mAntialiasMode));
+	mShapeKey.push_back((float)mFillRule);
+
+	for (int c = 0; c < contourCount; c++) {
+		mShapeKey.push_back((float)contourCounts[c]);
+	}
+
+	for (int i = 0; i < count; i++) {
+		mShapeKey.push_back(vertices[i].position[0] - originX);
+		mShapeKey.push_back(vertices[i].position[1] - originY);
+	}
+
+	const SpanList *spans = mShapeCache.Find(mShapeKey);
+
+	if (spans) {
+		RASTER_STAT_INC(mStats, shapeCacheHits);
+	}
+	else {
+		RASTER_STAT_INC(mStats, shapeCacheMisses);
+
+		SpanList *captured = mShapeCache.Insert(mShapeKey);
+
+		BeginSpanCapture(captured);
+
+		if (minX >= 0.0f && minY >= 0.0f && maxX <= mWidth && maxY <= mHeight) {
+			RasterizePolygon(vertices, contourCounts, contourCount, minX, maxX, minY, maxY);
+			EndSpanCapture();
+
+			captured->Translate(-originX, -originY);
+		}
+		else {
+			// The capture is clipped to the framebuffer, so a polygon partly outside it is rasterized at the origin
+			// of its bounds, where it may touch the edges of the framebuffer and keeps the bounds tests
+			InsideClipScope inside(mInsideClip, false);
+
+			if ((int)mCachedVertices.size() < count) {
+				mCachedVertices.resize(count);
+				RASTER_STAT_INC(mStats, heapAllocations);
+			}
+
+			for (int i = 0; i < count; i++) {
+				mCachedVertices[i] = vertices[i];
+				mCachedVertices[i].position = vertices[i].position - Vector2((float)originX, (float)originY);
+			}
+
+			RasterizePolygon(&mCachedVertices[0], contourCounts, contourCount, minX - originX, maxX - originX, minY - originY, maxY - originY);
+			EndSpanCapture();
+		}
+
+		spans = captured;
+	}
+
+	FillSpans(*spans, originX, originY, vertices[0].colour);
+
+	return true;
+}
+
+void Rasterizer::FillEdgeTable(float minY, float maxY, const Colour4 & colour, const TextureMapping * mapping)
+{
+	// Pixels are sampled at their centre, row y is covered where the polygon crosses y + 0.5;
+	// rows outside the clip rectangle are never visited
+	int clipBottom, clipTop;
+
+	GetClipRows(clipBottom, clipTop);
+
+	int bottom = std::max((int)ceilf(minY - 0.5f), clipBottom);
+	int top = std::min((int)ceilf(maxY - 0.5f), clipTop);
+
+	for (int y = bottom; y < top; y++) {
+		RASTER_STAT_INC(mStats, scanlines);
+
+		GatherCrossings(y + 0.5f);
+
+		// Walk the crossings in x order tracking the winding number, a span runs from where the winding
+		// becomes inside to where it becomes outside again
+		int winding = 0;
+		float spanStart = 0.0f;
+
+		for (size_t i = 0; i < mCrossings.size(); i++) {
+			bool wasInside = IsInside(winding);
+
+			winding += mCrossings[i].winding;
+
+			if (wasInside == IsInside(winding)) {
+				continue;
+			}
+
+			if (!wasInside) {
+				spanStart = mCrossings[i].x;
+				continue;
+			}
+
+			// Pixel x is covered if its centre x + 0.5 lies in [spanStart, crossing)
+			int x0 = std::max((int)ceilf(spanStart - 0.5f), 0);
+			int x1 = std::min((int)ceilf(mCrossings[i].x - 0.5f), mWidth);
+
+			if (x0 < x1 && mapping) {
+				WriteTexturedSpan(y, x0, x1, *mapping);
+			}
+			else if (x0 < x1) {
+				WriteSpan(y, x0, x1, colour);
+			}
+		}
+	}
+}
+
+void Rasterizer::BuildEdgeTable(const Vertex2d * vertices, const int * contourCounts, int contourCount)
+{
+	RASTER_STAT_ONLY(size_t capacity = mEdgeTable.capacity());
+
+	mEdgeTable.clear();
+
+	for (int c = 0; c < contourCount; c++) {
+		int count = contourCounts[c];
+
+		for (int i = 0; i < count; i++) {
+			const Vector2 &p0 = vertices[i].position;
+			const Vector2 &p1 = vertices[i + 1 < count ? i + 1 : 0].position;
+
+			if (p0[1] != p1[1]) {
+				mEdgeTable.push_back(EdgeBucket(p0, p1));
+			}
+		}
+
+		vertices += count;
+	}
+
+	RASTER_STAT_ADD(mStats, heapAllocations, mEdgeTable.capacity() != capacity ? 1 : 0);
+
+	std::sort(mEdgeTable.begin(), mEdgeTable.end(), edge_less_than_key());
+
+	mActiveEdges.clear();
+	mNextEdge = 0;
+}
+
+void Rasterizer::GatherCrossings(float sampleY)
+{
+	while (mNextEdge < (int)mEdgeTable.size() && mEdgeTable[mNextEdge].yMin <= sampleY) {
+		mActiveEdges.push_back(mNextEdge++);
+	}
+
+	mCrossings.clear();
+
+	for (size_t i = 0; i < mActiveEdges.size();) {
+		const EdgeBucket &edge = mEdgeTable[mActiveEdges[i]];
+
+		// Edges ending at or below the row are retired
+		if (edge.yMax <= sampleY) {
+			mActiveEdges[i] = mActiveEdges.back();
+			mActiveEdges.pop_back();
+			continue;
+		}
+
+		SampleCrossing crossing;
+
+		crossing.x = edge.XAt(sampleY);
+		crossing.winding = edge.winding;
+		mCrossings.push_back(crossing);
+
+		RASTER_STAT_INC(mStats, edgeIntersections);
+
+		i++;
+	}
+
+	std::sort(mCrossings.begin(), mCrossings.end(), crossing_less_than_key());
+}
+
+void Rasterizer::CollapseSamples(int y, int x0, int x1)
+{
+	if (mFramebuffer->GetSampleCount() == 1) {
+		return;
+	}
+
+	for (int x = x0; x < x1; x++) {
+		int index = mFramebuffer->PixelIndex(x, y);
+
+		if (mFramebuffer->IsExpanded(index)) {
+			mFramebuffer->CollapsePixel(index);
+		}
+	}
+}
+
+void Rasterizer::WriteSolidRun(int y, int x0, int x1, const Colour4 & colour)
+{
+	if (mBlendMode == Rasterizer::ALPHA_BLEND) {
+		BlendSolidRun(y, x0, x1, colour, colour[3]);
+		return;
+	}
+
+	// A linear row is a single run, a tiled row one run per tile
+	for (int x = x0; x < x1; ) {
+		int count = std::min(x1 - x, mFramebuffer->GetRowRun(x));
+
+		PixelKernels::FillSpan(mFramebuffer->GetPixel(x, y), count, colour);
+
+		x += count;
+	}
+
+	RASTER_STAT_ADD(mStats, pixelsWritten, x1 - x0);
+}
+
+void Rasterizer::BlendSolidRun(int y, int x0, int x1, const Colour4 & colour, float factor)
+{
+	for (int x = x0; x < x1; ) {
+		int count = std::min(x1 - x, mFramebuffer->GetRowRun(x));
+
+		PixelKernels::BlendSpan(mFramebuffer->GetPixel(x, y), count, colour, factor);
+
+		x += count;
+	}
+
+	RASTER_STAT_ADD(mStats, pixelsBlended, x1 - x0);
+}
+
+void Rasterizer::WritePixelRun(int y, int x0, int x1, const PixelRGBA * src)
+{
+	bool blend = mBlendMode == Rasterizer::ALPHA_BLEND;
+
+	for (int x = x0; x < x1; ) {
+		int count = std::min(x1 - x, mFramebuffer->GetRowRun(x));
+
+		if (blend) {
+			PixelKernels::BlendPixels(mFramebuffer->GetPixel(x, y), src + (x - x0), count);
+		}
+		else {
+			PixelKernels::CopySpan(mFramebuffer->GetPixel(x, y), src + (x - x0), count);
+		}
+
+		x += count;
+	}
+
+	RASTER_STAT_ADD(mStats, pixelsBlended, blend ? x1 - x0 : 0);
+	RASTER_STAT_ADD(mStats, pixelsWritten, blend ? 0 : x1 - x0);
+}
+
+void Rasterizer::BlendCoverageRun(int x, int y, int count, bool vertical, const Colour4 & colour, float alpha, const float * coverage)
+{
+	int stride = vertical ? mFramebuffer->GetColumnStride() : 1;
+
+	for (int i = 0; i < count; ) {
+		int run = std::min(count - i, vertical ? mFramebuffer->GetColumnRun(y) : mFramebuffer->GetRowRun(x));
+
+		PixelKernels::BlendCoverage(mFramebuffer->GetPixel(x, y), stride, run, colour, alpha, coverage + i);
+
+		i += run;
+		x += vertical ? 0 : run;
+		y += vertical ? run : 0;
+	}
+
+	RASTER_STAT_ADD(mStats, pixelsBlended, count);
+}
+
+void Rasterizer::WriteSpan(int y, int x0, int x1, const Colour4 & colour)
+{
+	if (mCapture) {
+		mCapture->Add(y, x0, x1);
+	}
+	else if (IsMaskActive()) {
+		WriteMaskedSpan(y, x0, x1, colour, NULL);
+	}
+	else if (mOcclusionMode == LAYER_OCCLUSION) {
+		WriteVisibleSpan(y, x0, x1, colour, NULL);
+	}
+	else {
+		CollapseSamples(y, x0, x1);
+		WriteSolidRun(y, x0, x1, colour);
+	}
+}
+
+const std::vector<StencilRun> & Rasterizer::MaskRuns(int y, int x0, int x1)
+{
+	mMaskRuns.clear();
+
+	x0 = std::max(x0, mClipRect.left);
+	x1 = std::min(x1, mClipRect.right);
+
+	if (y < mClipRect.bottom || y >= mClipRect.top || x0 >= x1) {
+		return mMaskRuns;
+	}
+
+	StencilRun clipped = { x0, x1 };
+
+	if (mStencilMode != STENCIL_TEST) {
+		mMaskRuns.push_back(clipped);
+		return mMaskRuns;
+	}
+
+	// The span is intersected with the row's stencil runs, starting at the first run that ends after x0
+	const std::vector<StencilRun> &runs = mFramebuffer->GetStencilRuns(y, mStencilValue);
+	std::vector<StencilRun>::const_iterator run = std::lower_bound(runs.begin(), runs.end(), x0, run_ends_before_key());
+
+	for (; run != runs.end() && run->x0 < x1; ++run) {
+		clipped.x0 = std::max(x0, run->x0);
+		clipped.x1 = std::min(x1, run->x1);
+		mMaskRuns.push_back(clipped);
+	}
+
+	return mMaskRuns;
+}
+
+void Rasterizer::WriteMaskedSpan(int y, int x0, int x1, const Colour4 & colour, const TextureMapping * mapping)
+{
+	const std::vector<StencilRun> &runs = MaskRuns(y, x0, x1);
+
+	for (size_t i = 0; i < runs.size(); i++) {
+		int start = runs[i].x0;
+		int end = runs[i].x1;
+
+		if (mStencilMode == STENCIL_WRITE) {
+			mFramebuffer->WriteStencil(y, start, end, mStencilValue);
+		}
+		else if (mOcclusionMode == LAYER_OCCLUSION) {
+			WriteVisibleSpan(y, start, end, colour, mapping);
+		}
+		else if (mapping) {
+			WriteTextureRun(y, start, end, *mapping);
+		}
+		else {
+			CollapseSamples(y, start, end);
+			WriteSolidRun(y, start, end, colour);
+		}
+	}
+}
+
+void Rasterizer::SetStencilMode(StencilMode mode)
+{
+	if (mode != NO_STENCIL && !mFramebuffer->HasStencil()) {
+		mFramebuffer->ClearStencil(0);
+	}
+
+	mStencilMode = mode;
+}
+
+void Rasterizer::BeginSpanCapture(SpanList * spans)
+{
+	spans->Clear();
+	mCapture = spans;
+}
+
+void Rasterizer::EndSpanCapture()
+{
+	if (mCapture) {
+		mCapture->Finish();
+	}
+
+	mCapture = NULL;
+}
+
+void Rasterizer::FillSpans(const SpanList & spans, int dx, int dy, const Colour4 & colour)
+{
+	TRACE_SCOPE_ARG("FillSpans", "spans", spans.GetSpanCount());
+	RASTER_STAT_INC(mStats, spanLists);
+
+	// The bounds of the list cull or accept all of its spans at once
+	int minX, minY, maxX, maxY;
+
+	if (!spans.GetBounds(minX, minY, maxX, maxY)) {
+		return;
+	}
+
+	ClipResult clip = ClassifyBounds((float)(minX + dx), (float)(maxX + dx - 1), (float)(minY + dy), (float)(maxY + dy - 1), 0.0f);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
+	float alpha = mBlendMode == Rasterizer::ALPHA_BLEND ? colour[3] : 1.0f;
+	const Span *span = spans.GetSpans();
+
+	for (int i = 0; i < spans.GetSpanCount(); i++, span++) {
+		int y = span->y + dy;
+		int x0 = std::max(span->x0 + dx, 0);
+		int x1 = std::min(span->x1 + dx, mWidth);
+
+		if (y < 0 || y >= mHeight || x0 >= x1) {
+			continue;
+		}
+
+		if (mCapture) {
+			mCapture->Add(y, x0, x1, span->coverage);
+			continue;
+		}
+
+		// Full spans take the aliased path with its occlusion test, the stencil is written where at least half a pixel is covered
+		if (span->coverage >= 1.0f - SpanList::COVERAGE_EPSILON || mStencilMode == STENCIL_WRITE) {
+			if (span->coverage >= 0.5f) {
+				WriteSpan(y, x0, x1, colour);
+			}
+
+			continue;
+		}
+
+		// Partial spans are blended by their coverage like the edges of an anti-aliased fill
+		if (!IsMaskActive()) {
+			CollapseSamples(y, x0, x1);
+			BlendSolidRun(y, x0, x1, colour, alpha * span->coverage);
+			continue;
+		}
+
+		const std::vector<StencilRun> &runs = MaskRuns(y, x0, x1);
+
+		for (size_t r = 0; r < runs.size(); r++) {
+			CollapseSamples(y, runs[r].x0, runs[r].x1);
+			BlendSolidRun(y, runs[r].x0, runs[r].x1, colour, alpha * span->coverage);
+		}
+	}
+}
+
+void Rasterizer::WriteVisibleSpan(int y, int x0, int x1, const Colour4 & colour, const TextureMapping * mapping)
+{
+	bool opaque = mBlendMode == Rasterizer::NO_BLEND;
+	int start = x0;
+	int visible = 0;
+
+	while (start < x1) {
+		int end = mLayerBuffer.NextVisibleRun(y, start, x1, mLayer);
+
+		if (start == end) {
+			break;
+		}
+
+		if (mapping) {
+			WriteTextureRun(y, start, end, *mapping);
+		}
+		else {
+			CollapseSamples(y, start, end);
+			WriteSolidRun(y, start, end, colour);
+		}
+
+		if (opaque) {
+			mLayerBuffer.Write(y, start, end, mLayer);
+		}
+
+		visible += end - start;
+		start = end;
+	}
+
+	RASTER_STAT_ADD(mStats, pixelsOccluded, x1 - x0 - visible);
+}
+
+bool Rasterizer::IsOccluded(float minX, float maxX, float minY, float maxY)
+{
+	if (mOcclusionMode != LAYER_OCCLUSION || mCapture) {
+		return false;
+	}
+
+	int x0 = std::max((int)ceilf(minX - 0.5f), 0);
+	int x1 = std::min((int)ceilf(maxX - 0.5f), mWidth);
+	int y0 = std::max((int)ceilf(minY - 0.5f), 0);
+	int y1 = std::min((int)ceilf(maxY - 0.5f), mHeight);
+
+	if (!mLayerBuffer.IsHidden(x0, y0, x1, y1, mLayer)) {
+		return false;
+	}
+
+	RASTER_STAT_INC(mStats, occludedPrimitives);
+	return true;
+}
+
+void Rasterizer::SetOcclusionMode(OcclusionMode mode)
+{
+	if (mode == LAYER_OCCLUSION) {
+		mLayerBuffer.Resize(mWidth, mHeight);
+	}
+
+	mOcclusionMode = mode;
+}
+
+void Rasterizer::WriteRect(int x0, int y0, int x1, int y1, const Colour4 & colour)
+{
+	for (int y = y0; y < y1 && x0 < x1; y++) {
+		RASTER_STAT_INC(mStats, scanlines);
+		WriteSpan(y, x0, x1, colour);
+	}
+}
+
+void Rasterizer::WriteStencilRect(int x0, int y0, int x1, int y1)
+{
+	for (int y = y0; y < y1 && x0 < x1; y++) {
+		RASTER_STAT_INC(mStats, scanlines);
+		WriteMaskedSpan(y, x0, x1, Colour4(), NULL);
+	}
+}
+
+void Rasterizer::WriteTexturedSpan(int y, int x0, int x1, const TextureMapping & mapping)
+{
+	if (mCapture) {
+		mCapture->Add(y, x0, x1);
+	}
+	else if (IsMaskActive()) {
+		WriteMaskedSpan(y, x0, x1, Colour4(), &mapping);
+	}
+	else if (mOcclusionMode == LAYER_OCCLUSION) {
+		WriteVisibleSpan(y, x0, x1, Colour4(), &mapping);
+	}
+	else {
+		WriteTextureRun(y, x0, x1, mapping);
+	}
+}
+
+void Rasterizer::WriteTextureRun(int y, int x0, int x1, const TextureMapping & mapping)
+{
+	if ((int)mSpanColours.size() < x1 - x0) {
+		mSpanColours.resize(x1 - x0);
+		RASTER_STAT_INC(mStats, heapAllocations);
+	}
+
+	// Texture coordinates at the centre of the span's first pixel
+	float cx = x0 + 0.5f;
+	float cy = y + 0.5f;
+	float u = mapping.u + mapping.dudx * cx + mapping.dudy * cy;
+	float v = mapping.v + mapping.dvdx * cx + mapping.dvdy * cy;
+
+	mTexture->SampleSpan(u, v, mapping.dudx, mapping.dvdx, x1 - x0, &mSpanColours[0]);
+
+	CollapseSamples(y, x0, x1);
+	WritePixelRun(y, x0, x1, &mSpanColours[0]);
+}
+
+void Rasterizer::AntialiasedFillPolygon2D(const Vertex2d * vertices, const int * contourCounts, int contourCount)
+{
+	int count = CountContourVertices(contourCounts, contourCount);
+	float minX = vertices[0].position[0];
+	float maxX = minX;
+	float minY = vertices[0].position[1];
+	float maxY = minY;
+
+	for (int i = 1; i < count; i++) {
+		minX = std::min(minX, vertices[i].position[0]);
+		maxX = std::max(maxX, vertices[i].position[0]);
+		minY = std::min(minY, vertices[i].position[1]);
+		maxY = std::max(maxY, vertices[i].position[1]);
+	}
+
+	// Accumulate over the part of the bounding box inside the clip rectangle only, edges outside the region
+	// are projected onto its border
+	int clipBottom, clipTop;
+
+	GetClipRows(clipBottom, clipTop);
+
+	int left = std::max((int)floorf(minX), mCapture ? 0 : std::max(mClipRect.left, 0));
+	int right = std::min((int)ceilf(maxX), mCapture ? mWidth : std::min(mClipRect.right, mWidth));
+	int bottom = std::max((int)floorf(minY), clipBottom);
+	int top = std::min((int)ceilf(maxY), clipTop);
+
+	if (left >= right || bottom >= top) {
+		return;
+	}
+
+	mAccumulator.Reset(left, bottom, right - left, top - bottom);
+
+	for (int c = 0, first = 0; c < contourCount; first += contourCounts[c++]) {
+		mAccumulator.AddContour(vertices + first, contourCounts[c]);
+	}
+
+	if ((int)mCoverage.size() < right - left) {
+		mCoverage.resize(right - left);
+		RASTER_STAT_INC(mStats, heapAllocations);
+	}
+
+	bool evenOdd = mFillRule == EVEN_ODD;
+	int first, last;
+
+	for (int row = 0; row < top - bottom; row++) {
+		RASTER_STAT_INC(mStats, scanlines);
+
+		if (mAccumulator.ResolveRow(row, evenOdd, &mCoverage[0], first, last)) {
+			WriteCoverageRow(left + first, bottom + row, &mCoverage[first], last - first + 1, vertices[0].colour);
+		}
+	}
+}
+
+void Rasterizer::MultisampleFillPolygon2D(const Vertex2d * vertices, const int * contourCounts, int contourCount, const Vertex2d * gradient)
+{
+	int count = CountContourVertices(contourCounts, contourCount);
+	float minX = vertices[0].position[0];
+	float maxX = minX;
+	float minY = vertices[0].position[1];
+	float maxY = minY;
+
+	for (int i = 1; i < count; i++) {
+		minX = std::min(minX, vertices[i].position[0]);
+		maxX = std::max(maxX, vertices[i].position[0]);
+		minY = std::min(minY, vertices[i].position[1]);
+		maxY = std::max(maxY, vertices[i].position[1]);
+	}
+
+	// Sample positions lie strictly inside their pixel, so the bounding box clipped to the framebuffer holds every covered sample;
+	// rows outside the clip rectangle are skipped
+	int clipBottom, clipTop;
+
+	GetClipRows(clipBottom, clipTop);
+
+	int left = std::max((int)floorf(minX), 0);
+	int right = std::min((int)ceilf(maxX), mWidth);
+	int bottom = std::max((int)floorf(minY), clipBottom);
+	int top = std::min((int)ceilf(maxY), clipTop);
+
+	if (left >= right || bottom >= top) {
+		return;
+	}
+
+	if ((int)mSampleMasks.size() < right - left) {
+		mSampleMasks.resize(right - left, 0);
+		RASTER_STAT_INC(mStats, heapAllocations);
+	}
+
+	int samples = mFramebuffer->GetSampleCount();
+	const float *offsets = mFramebuffer->GetSampleOffsets();
+
+	// The active edge list advances in increasing y, so visit the samples of a row in the order of their y offset
+	int order[8];
+
+	for (int s = 0; s < samples; s++) {
+		int i = s;
+
+		for (; i > 0 && offsets[2 * order[i - 1] + 1] > offsets[2 * s + 1]; i--) {
+			order[i] = order[i - 1];
+		}
+
+		order[i] = s;
+	}
 
-						start++;
-					}
+	BuildEdgeTable(vertices, contourCounts, contourCount);
+
+	for (int y = bottom; y < top; y++) {
+		RASTER_STAT_INC(mStats, scanlines);
+
+		int first = right;
+		int last = left - 1;
+
+		for (int o = 0; o < samples; o++) {
+			int s = order[o];
+			float sampleX = offsets[2 * s];
+
+			GatherCrossings(y + offsets[2 * s + 1]);
+
+			int winding = 0;
+
+			for (int i = 0; i + 1 < (int)mCrossings.size(); i++) {
+				winding += mCrossings[i].winding;
+
+				if (!IsInside(winding)) {
+					continue;
 				}
 
-				draw = !draw;
+				// Pixels whose sample lies in [x0, x1) are covered
+				int x0 = std::max((int)ceilf(mCrossings[i].x - sampleX), left);
+				int x1 = std::min((int)ceilf(mCrossings[i + 1].x - sampleX), right);
+
+				for (int x = x0; x < x1; x++) {
+					mSampleMasks[x - left] |= (unsigned char)(1 << s);
+				}
+
+				if (x0 < x1) {
+					first = std::min(first, x0);
+					last = std::max(last, x1 - 1);
+				}
 			}
 		}
 
-		delete lutTable;
+		if (first <= last) {
+			WriteSampleRow(first, y, &mSampleMasks[first - left], last - first + 1, vertices[0].colour, gradient);
+		}
+	}
+}
+
+void Rasterizer::WriteSampleRow(int x, int y, unsigned char * masks, int count, const Colour4 & colour, const Vertex2d * gradient)
+{
+	int samples = mFramebuffer->GetSampleCount();
+	unsigned char fullMask = (unsigned char)((1 << samples) - 1);
+	bool blend = mBlendMode == Rasterizer::ALPHA_BLEND;
+
+	// A captured pixel's coverage is the fraction of its samples that are covered
+	if (mCapture) {
+		if ((int)mCoverage.size() < count) {
+			mCoverage.resize(count);
+			RASTER_STAT_INC(mStats, heapAllocations);
+		}
+
+		for (int i = 0; i < count; i++) {
+			int covered = 0;
+
+			for (int s = 0; s < samples; s++) {
+				covered += (masks[i] >> s) & 1;
+			}
+
+			mCoverage[i] = (float)covered / samples;
+			masks[i] = 0;
+		}
+
+		mCapture->AddCoverageRow(x, y, &mCoverage[0], count);
+		return;
+	}
+
+	// Masked pixels lose their sample coverage, the gaps between the unmasked runs are cleared
+	if (IsMaskActive()) {
+		const std::vector<StencilRun> &runs = MaskRuns(y, x, x + count);
+		int next = x;
+
+		for (size_t r = 0; r < runs.size(); r++) {
+			memset(masks + (next - x), 0, runs[r].x0 - next);
+			next = runs[r].x1;
+		}
+
+		memset(masks + (next - x), 0, x + count - next);
+	}
+
+	// Gradient colours are interpolated by projecting the pixel centre onto the gradient axis
+	Vector2 axis;
+	float axisScale = 0.0f;
+
+	if (gradient) {
+		axis = gradient[1].position - gradient[0].position;
+		axisScale = axis.DotProduct(axis);
+		axisScale = axisScale > 0.0f ? 1.0f / axisScale : 0.0f;
+	}
+
+	int i = 0;
+
+	while (i < count) {
+		int index = mFramebuffer->PixelIndex(x + i, y);
+
+		if (masks[i] == 0) {
+			i++;
+			continue;
+		}
+
+		if (!gradient && masks[i] == fullMask && !mFramebuffer->IsExpanded(index)) {
+			// Run of fully covered single-colour pixels, written as a solid span
+			int start = i;
+
+			while (i < count && masks[i] == fullMask && !mFramebuffer->IsExpanded(mFramebuffer->PixelIndex(x + i, y))) {
+				masks[i++] = 0;
+			}
+
+			WriteSolidRun(y, x + start, x + i, colour);
+
+			continue;
+		}
+
+		Colour4 c = colour;
+
+		if (gradient) {
+			Vector2 centre((float)(x + i) + 0.5f, (float)y + 0.5f);
+			float t = (centre - gradient[0].position).DotProduct(axis) * axisScale;
+
+			c = Interpolate(gradient[0].colour, gradient[1].colour, std::min(std::max(t, 0.0f), 1.0f));
+		}
+
+		float factor = blend ? c[3] : 1.0f;
+
+		if (masks[i] == fullMask && !mFramebuffer->IsExpanded(index)) {
+			PixelRGBA *pixel = mFramebuffer->GetBuffer() + index;
+
+			*pixel = blend ? Interpolate(*pixel, c, factor) : c;
+		}
+		else {
+			// Partially covered or already expanded, write the covered samples only
+			PixelRGBA *sample = mFramebuffer->ExpandPixel(index);
+
+			for (int s = 0; s < samples; s++) {
+				if (masks[i] & (1 << s)) {
+					sample[s] = blend ? Interpolate(sample[s], c, factor) : c;
+				}
+			}
+		}
+
+		RASTER_STAT_ADD(mStats, pixelsBlended, blend ? 1 : 0);
+		RASTER_STAT_ADD(mStats, pixelsWritten, blend ? 0 : 1);
+
+		masks[i++] = 0;
+	}
+}
+
+void Rasterizer::WriteCoverageRow(int x, int y, const float * coverage, int count, const Colour4 & colour)
+{
+	if (mCapture) {
+		mCapture->AddCoverageRow(x, y, coverage, count);
+		return;
+	}
+
+	if (!IsMaskActive()) {
+		WriteCoverageRun(x, y, coverage, count, colour);
+		return;
+	}
+
+	const std::vector<StencilRun> &runs = MaskRuns(y, x, x + count);
+
+	for (size_t i = 0; i < runs.size(); i++) {
+		WriteCoverageRun(runs[i].x0, y, coverage + (runs[i].x0 - x), runs[i].x1 - runs[i].x0, colour);
+	}
+}
+
+void Rasterizer::WriteCoverageRun(int x, int y, const float * coverage, int count, const Colour4 & colour)
+{
+	// Coverage within this distance of 0 or 1 is treated as empty or full, which absorbs accumulation round-off
+	const float epsilon = 1.0f / 4096.0f;
+
+	float alpha = mBlendMode == Rasterizer::ALPHA_BLEND ? colour[3] : 1.0f;
+	int i = 0;
+
+	while (i < count) {
+		int start = i;
+
+		if (coverage[i] >= 1.0f - epsilon) {
+			// Interior run, written as a solid span
+			while (i < count && coverage[i] >= 1.0f - epsilon) { i++; }
+
+			CollapseSamples(y, x + start, x + i);
+			WriteSolidRun(y, x + start, x + i, colour);
+		}
+		else if (coverage[i] <= epsilon) {
+			while (i < count && coverage[i] <= epsilon) { i++; }
+		}
+		else {
+			// Edge run, blended by coverage
+			while (i < count && coverage[i] > epsilon && coverage[i] < 1.0f - epsilon) { i++; }
+
+			CollapseSamples(y, x + start, x + i);
+			BlendCoverageRun(x + start, y, i - start, false, colour, alpha, coverage + start);
+		}
+	}
+}
+
+void Rasterizer::ScanlineTexturedFillPolygon2D(const Vertex2d * vertices, int count)
+{
+	TRACE_SCOPE_ARG("ScanlineTexturedFillPolygon2D", "vertices", count);
+	RASTER_STAT_INC(mStats, texturedPolygons);
+
+	if (!mTexture || mTexture->GetWidth() == 0 || count < 3) {
+		return;
+	}
+
+	vertices = TransformVertices(vertices, count);
+
+	// Texture coordinates are an affine function of the position, fitted to the largest triangle fanning out from the first vertex
+	const Vector2 &p0 = vertices[0].position;
+	float bestArea = 0.0f;
+	int best = 0;
+
+	for (int i = 1; i + 1 < count; i++) {
+		Vector2 e1 = vertices[i].position - p0;
+		Vector2 e2 = vertices[i + 1].position - p0;
+		float area = fabsf(e1[0] * e2[1] - e2[0] * e1[1]);
+
+		if (area > bestArea) {
+			bestArea = area;
+			best = i;
+		}
+	}
+
+	if (bestArea == 0.0f) {
+		return;
+	}
+
+	Vector2 e1 = vertices[best].position - p0;
+	Vector2 e2 = vertices[best + 1].position - p0;
+	Vector2 t1 = vertices[best].uv - vertices[0].uv;
+	Vector2 t2 = vertices[best + 1].uv - vertices[0].uv;
+	float det = e1[0] * e2[1] - e2[0] * e1[1];
+	TextureMapping mapping;
+
+	mapping.dudx = (t1[0] * e2[1] - t2[0] * e1[1]) / det;
+	mapping.dudy = (t2[0] * e1[0] - t1[0] * e2[0]) / det;
+	mapping.dvdx = (t1[1] * e2[1] - t2[1] * e1[1]) / det;
+	mapping.dvdy = (t2[1] * e1[0] - t1[1] * e2[0]) / det;
+	mapping.u = vertices[0].uv[0] - mapping.dudx * p0[0] - mapping.dudy * p0[1];
+	mapping.v = vertices[0].uv[1] - mapping.dvdx * p0[0] - mapping.dvdy * p0[1];
+
+	float minX = p0[0], maxX = p0[0], minY = p0[1], maxY = p0[1];
+
+	for (int i = 1; i < count; i++) {
+		minX = std::min(minX, vertices[i].position[0]);
+		maxX = std::max(maxX, vertices[i].position[0]);
+		minY = std::min(minY, vertices[i].position[1]);
+		maxY = std::max(maxY, vertices[i].position[1]);
+	}
+
+	ClipResult clip = ClassifyBounds(minX, maxX, minY, maxY, CULL_MARGIN);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
+	if (IsOccluded(minX, maxX, minY, maxY)) {
+		return;
 	}
+
+	// An axis-aligned rectangle needs no edge table, every row is one span across its width
+	if (IsAxisAlignedRectangle(vertices, count, minX, maxX, minY, maxY)) {
+		int x0 = std::max((int)ceilf(minX - 0.5f), 0);
+		int x1 = std::min((int)ceilf(maxX - 0.5f), mWidth);
+		int y0 = std::max((int)ceilf(minY - 0.5f), 0);
+		int y1 = std::min((int)ceilf(maxY - 0.5f), mHeight);
+
+		for (int y = y0; y < y1 && x0 < x1; y++) {
+			RASTER_STAT_INC(mStats, scanlines);
+			WriteTexturedSpan(y, x0, x1, mapping);
+		}
+
+		return;
+	}
+
+	BuildEdgeTable(vertices, &count, 1);
+	FillEdgeTable(minY, maxY, vertices[0].colour, &mapping);
 }
 
 void Rasterizer::ScanlineInterpolatedFillPolygon2D(const Vertex2d * vertices, int count)
@@ -389,6 +1803,27 @@ void Rasterizer::ScanlineInterpolatedFillPolygon2D(const Vertex2d * vertices, in
 	//		This exercise will be more straightfoward if Ex 1.3 has been implemented in DrawLine2D
 	//Use Test 7 to test your solution
 
+	TRACE_SCOPE_ARG("ScanlineInterpolatedFillPolygon2D", "vertices", count);
+	RASTER_STAT_INC(mStats, interpolatedPolygons);
+
+	if (count <= 0) {
+		return;
+	}
+
+	vertices = TransformVertices(vertices, count);
+
+	float minX, maxX, minY, maxY;
+
+	GetPositionBounds(vertices, count, minX, maxX, minY, maxY);
+
+	ClipResult clip = ClassifyBounds(minX, maxX, minY, maxY, CULL_MARGIN);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
 	int minShapeY = INT_MAX;
 	int maxShapeY = INT_MIN;
 	int minShapeX = INT_MAX;
@@ -413,10 +1848,16 @@ void Rasterizer::ScanlineInterpolatedFillPolygon2D(const Vertex2d * vertices, in
 	ScanlineLUTItem l;
 	Vector2 point;
 
-	for (int y = minShapeY; y < maxShapeY; y++) {
-		if (y < 0) { y = 0;  continue; }
+	// Only the rows inside the clip rectangle are visited
+	int clipBottom, clipTop;
+
+	GetClipRows(clipBottom, clipTop);
+
+	for (int y = std::max(minShapeY, clipBottom); y < std::min(maxShapeY, clipTop); y++) {
+		RASTER_STAT_INC(mStats, scanlines);
 
 		std::vector<ScanlineLUTItem> *lutTable = new std::vector<ScanlineLUTItem>;
+		RASTER_STAT_INC(mStats, heapAllocations);
 
 		for (int v = 0; v < count;) {
 			Vector2 v1 = vertices[v++].position;
@@ -447,7 +1888,7 @@ void Rasterizer::ScanlineInterpolatedFillPolygon2D(const Vertex2d * vertices, in
 
 				l.colour = colour;// vertices[v - 1].colour;
 				l.pos_x = x;
-				lutTable->push_back(l);
+				PushScanlineItem(lutTable, l, mStats);
 			}
 		}
 
@@ -489,7 +1930,7 @@ void Rasterizer::ScanlineInterpolatedFillPolygon2D(const Vertex2d * vertices, in
 
 								SetFGColour(colour);
 							}
-							DrawPoint2D(point);
+							PlotPoint2D(point);
 						}
 
 						start++;
@@ -504,13 +1945,293 @@ void Rasterizer::ScanlineInterpolatedFillPolygon2D(const Vertex2d * vertices, in
 	}
 }
 
-void Rasterizer::DrawCircle2D(const Circle2D & inCircle, bool filled)
+void Rasterizer::FillRect(int left, int bottom, int width, int height, const Colour4 & colour)
+{
+	TRACE_SCOPE("FillRect");
+	RASTER_STAT_INC(mStats, rectangles);
+
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+
+	ClipResult clip = ClassifyBounds((float)left, (float)(left + width - 1), (float)bottom, (float)(bottom + height - 1), 0.0f);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
+	if (IsOccluded((float)left, (float)(left + width), (float)bottom, (float)(bottom + height))) {
+		return;
+	}
+
+	WriteRect(std::max(left, 0), std::max(bottom, 0), std::min(left + width, mWidth), std::min(bottom + height, mHeight), colour);
+}
+
+void Rasterizer::BlitRect(int left, int bottom, const PixelRGBA * pixels, int width, int height, int stride)
+{
+	TRACE_SCOPE("BlitRect");
+	RASTER_STAT_INC(mStats, rectangles);
+
+	int x0 = std::max(left, 0);
+	int x1 = std::min(left + width, mWidth);
+	int y0 = std::max(bottom, 0);
+	int y1 = std::min(bottom + height, mHeight);
+
+	if (mStencilMode == STENCIL_WRITE) {
+		WriteStencilRect(x0, y0, x1, y1);
+		return;
+	}
+
+	for (int y = y0; y < y1 && x0 < x1; y++) {
+		const PixelRGBA *row = pixels + (y - bottom) * stride;
+
+		if (!IsMaskActive()) {
+			CollapseSamples(y, x0, x1);
+			WritePixelRun(y, x0, x1, row + (x0 - left));
+			continue;
+		}
+
+		const std::vector<StencilRun> &runs = MaskRuns(y, x0, x1);
+
+		for (size_t i = 0; i < runs.size(); i++) {
+			CollapseSamples(y, runs[i].x0, runs[i].x1);
+			WritePixelRun(y, runs[i].x0, runs[i].x1, row + (runs[i].x0 - left));
+		}
+	}
+}
+
+void Rasterizer::CopyRect(int srcLeft, int srcBottom, int width, int height, int dstLeft, int dstBottom)
+{
+	TRACE_SCOPE("CopyRect");
+	RASTER_STAT_INC(mStats, rectangles);
+
+	// Clip the source rectangle to the framebuffer, then the destination, shrinking both alike
+	int shiftX = dstLeft - srcLeft;
+	int shiftY = dstBottom - srcBottom;
+	int x0 = std::max(std::max(srcLeft, 0), -shiftX);
+	int x1 = std::min(std::min(srcLeft + width, mWidth), mWidth - shiftX);
+	int y0 = std::max(std::max(srcBottom, 0), -shiftY);
+	int y1 = std::min(std::min(srcBottom + height, mHeight), mHeight - shiftY);
+
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+
+	if (mStencilMode == STENCIL_WRITE) {
+		WriteStencilRect(x0 + shiftX, y0 + shiftY, x1 + shiftX, y1 + shiftY);
+		return;
+	}
+
+	PixelRGBA *buffer = mFramebuffer->GetBuffer();
+	bool blend = mBlendMode == Rasterizer::ALPHA_BLEND;
+	bool linear = mFramebuffer->GetLayout() == Framebuffer::LINEAR;
+	bool sameRow = shiftY == 0 && shiftX < x1 - x0 && -shiftX < x1 - x0;
+
+	if ((int)mSpanColours.size() < x1 - x0) {
+		mSpanColours.resize(x1 - x0);
+		RASTER_STAT_INC(mStats, heapAllocations);
+	}
+
+	// Copy rows in the order that never overwrites a source row before it is read
+	int first = shiftY > 0 ? y1 - 1 : y0;
+	int step = shiftY > 0 ? -1 : 1;
+
+	for (int i = 0, y = first; i < y1 - y0; i++, y += step) {
+		const PixelRGBA *src = buffer + y * mPitch + x0;
+		PixelRGBA *dst = buffer + (y + shiftY) * mPitch + x0 + shiftX;
+
+		// Multisampled source pixels are resolved first, their colour buffer entries are stale until then
+		CollapseSamples(y, x0, x1);
+
+		if (IsMaskActive()) {
+			// Only the destination runs inside the clip rectangle and stencil are written, from a copy of the source row
+			const std::vector<StencilRun> &runs = MaskRuns(y + shiftY, x0 + shiftX, x1 + shiftX);
+
+			mFramebuffer->ReadRow(x0, y, x1 - x0, &mSpanColours[0]);
+
+			for (size_t r = 0; r < runs.size(); r++) {
+				CollapseSamples(y + shiftY, runs[r].x0, runs[r].x1);
+				WritePixelRun(y + shiftY, runs[r].x0, runs[r].x1, &mSpanColours[runs[r].x0 - shiftX - x0]);
+			}
+
+			continue;
+		}
+
+		CollapseSamples(y + shiftY, x0 + shiftX, x1 + shiftX);
+
+		if (linear && !blend) {
+			memmove((void*)dst, (const void*)src, (x1 - x0) * sizeof(PixelRGBA));
+			RASTER_STAT_ADD(mStats, pixelsWritten, x1 - x0);
+		}
+		else if (linear && !sameRow) {
+			PixelKernels::BlendPixels(dst, src, x1 - x0);
+			RASTER_STAT_ADD(mStats, pixelsBlended, x1 - x0);
+		}
+		else {
+			// Tiled rows, and blending a row onto itself, go through a copy of the source row
+			mFramebuffer->ReadRow(x0, y, x1 - x0, &mSpanColours[0]);
+			WritePixelRun(y + shiftY, x0 + shiftX, x1 + shiftX, &mSpanColours[0]);
+		}
+	}
+}
+
+void Rasterizer::BlitCoverageMask(int x, int y, const unsigned char * mask, int width, int height, int stride, const Colour4 & colour)
+{
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+
+	// Glyphs outside the clip rectangle are skipped before their coverage is converted
+	ClipResult clip = ClassifyBounds((float)x, (float)(x + width - 1), (float)y, (float)(y + height - 1), 0.0f);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
+	int x0 = std::max(x, 0);
+	int x1 = std::min(x + width, mWidth);
+	int y0 = std::max(y, 0);
+	int y1 = std::min(y + height, mHeight);
+
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+
+	if ((int)mCoverage.size() < x1 - x0) {
+		mCoverage.resize(x1 - x0);
+		RASTER_STAT_INC(mStats, heapAllocations);
+	}
+
+	float alpha = mBlendMode == Rasterizer::ALPHA_BLEND ? colour[3] : 1.0f;
+
+	for (int row = y0; row < y1; row++) {
+		const unsigned char *coverage = mask + (row - y) * stride + (x0 - x);
+
+		for (int i = 0; i < x1 - x0; i++) {
+			mCoverage[i] = coverage[i] * (1.0f / 255.0f);
+		}
+
+		if (mCapture) {
+			mCapture->AddCoverageRow(x0, row, &mCoverage[0], x1 - x0);
+			continue;
+		}
+
+		if (!IsMaskActive()) {
+			CollapseSamples(row, x0, x1);
+			BlendCoverageRun(x0, row, x1 - x0, false, colour, alpha, &mCoverage[0]);
+			continue;
+		}
+
+		const std::vector<StencilRun> &runs = MaskRuns(row, x0, x1);
+
+		for (size_t i = 0; i < runs.size(); i++) {
+			CollapseSamples(row, runs[i].x0, runs[i].x1);
+			BlendCoverageRun(runs[i].x0, row, runs[i].x1 - runs[i].x0, false, colour, alpha, &mCoverage[runs[i].x0 - x0]);
+		}
+	}
+}
+
+void Rasterizer::DrawCircle2D(const Circle2D & circle, bool filled)
 {
 	//TODO:
 	//Ex 2.5 Implement Rasterizer::DrawCircle2D method so that it can draw a filled circle.
 	//Note: For a simple solution, you can first attempt to draw an unfilled circle in the same way as drawing an unfilled polygon.
 	//Use Test 8 to test your solution
 
+	Circle2D inCircle = circle;
+
+	if (!mIdentityTransform) {
+		inCircle.centre = mTransform.Apply(circle.centre);
+		inCircle.radius = circle.radius * mTransform.ScaleFactor();
+	}
+
+	TRACE_SCOPE_ARG("DrawCircle2D", "radius", inCircle.radius);
+	RASTER_STAT_INC(mStats, circles);
+
+	ClipResult clip = ClassifyBounds(inCircle.centre[0] - inCircle.radius, inCircle.centre[0] + inCircle.radius,
+		inCircle.centre[1] - inCircle.radius, inCircle.centre[1] + inCircle.radius, CULL_MARGIN);
+
+	if (clip == CLIP_OUTSIDE) {
+		return;
+	}
+
+	InsideClipScope inside(mInsideClip, clip == CLIP_INSIDE);
+
+	if (!FillCachedCircle(inCircle, filled)) {
+		RasterizeCircle2D(inCircle, filled);
+	}
+}
+
+bool Rasterizer::FillCachedCircle(const Circle2D & inCircle, bool filled)
+{
+	// Overlapping rows of a filled circle are blended more than once, which replayed spans would not reproduce.
+	// Circles are cached whole and clipped by FillSpans at replay, so only those nearly as large as the framebuffer
+	// cannot be held.
+	if (mShapeCache.GetCapacity() == 0 || mCapture || mBlendMode != NO_BLEND || mOcclusionMode != NO_OCCLUSION ||
+		2.0f * inCircle.radius + 3.0f >= std::min(mWidth, mHeight)) {
+		return false;
+	}
+
+	// The origin lies a pixel beyond the bounds, so the rounded points of a circle moved to it stay inside the framebuffer
+	int originX = (int)floorf(inCircle.centre[0] - inCircle.radius) - 1;
+	int originY = (int)floorf(inCircle.centre[1] - inCircle.radius) - 1;
+
+	mShapeKey.clear();
+	mShapeKey.push_back((float)CIRCLE_SHAPE);
+	mShapeKey.push_back(filled ? 1.0f : 0.0f);
+	mShapeKey.push_back(inCircle.radius);
+	mShapeKey.push_back(inCircle.centre[0] - originX);
+	mShapeKey.push_back(inCircle.centre[1] - originY);
+
+	const SpanList *spans = mShapeCache.Find(mShapeKey);
+
+	if (spans) {
+		RASTER_STAT_INC(mStats, shapeCacheHits);
+	}
+	else {
+		RASTER_STAT_INC(mStats, shapeCacheMisses);
+
+		SpanList *captured = mShapeCache.Insert(mShapeKey);
+
+		BeginSpanCapture(captured);
+
+		if (inCircle.centre[0] - inCircle.radius >= 0.0f && inCircle.centre[1] - inCircle.radius >= 0.0f &&
+			inCircle.centre[0] + inCircle.radius < mWidth && inCircle.centre[1] + inCircle.radius < mHeight) {
+			RasterizeCircle2D(inCircle, filled);
+			EndSpanCapture();
+
+			captured->Translate(-originX, -originY);
+		}
+		else {
+			// As for polygons, a circle partly outside the clipped capture is rasterized at the origin
+			InsideClipScope inside(mInsideClip, false);
+			Circle2D circle = inCircle;
+
+			circle.centre = inCircle.centre - Vector2((float)originX, (float)originY);
+
+			RasterizeCircle2D(circle, filled);
+			EndSpanCapture();
+		}
+
+		spans = captured;
+	}
+
+	// Unfilled circles are drawn with points in the foreground colour, filled ones leave it set to their colour
+	FillSpans(*spans, originX, originY, filled ? inCircle.colour : mFGColour);
+
+	if (filled) {
+		SetFGColour(inCircle.colour);
+	}
+
+	return true;
+}
+
+void Rasterizer::RasterizeCircle2D(const Circle2D & inCircle, bool filled)
+{
 	float radius = inCircle.radius;
 
 	float x = radius;
@@ -527,31 +2248,33 @@ void Rasterizer::DrawCircle2D(const Circle2D & inCircle, bool filled)
 			start.colour = inCircle.colour;
 			end.colour = inCircle.colour;
 
+			RASTER_STAT_ADD(mStats, scanlines, 4);
+
 			start.position = Vector2(inCircle.centre[0] + x, inCircle.centre[1] + y);
 			end.position = Vector2(inCircle.centre[0] - x, inCircle.centre[1] + y);
-			Rasterizer::DrawLine2D(start, end, 1);
+			RasterizeLine2D(start, end, 1);
 
 			start.position = Vector2(inCircle.centre[0] + x, inCircle.centre[1] - y);
 			end.position = Vector2(inCircle.centre[0] - x, inCircle.centre[1] - y);
-			Rasterizer::DrawLine2D(start, end, 1);
+			RasterizeLine2D(start, end, 1);
 
 			start.position = Vector2(inCircle.centre[0] + y, inCircle.centre[1] + x);
 			end.position = Vector2(inCircle.centre[0] - y, inCircle.centre[1] + x);
-			Rasterizer::DrawLine2D(start, end, 1);
+			RasterizeLine2D(start, end, 1);
 
 			start.position = Vector2(inCircle.centre[0] + y, inCircle.centre[1] - x);
 			end.position = Vector2(inCircle.centre[0] - y, inCircle.centre[1] - x);
-			Rasterizer::DrawLine2D(start, end, 1);
+			RasterizeLine2D(start, end, 1);
 		}
 		else {
-			DrawPoint2D(Vector2(inCircle.centre[0] + x, inCircle.centre[1] + y));
-			DrawPoint2D(Vector2(inCircle.centre[0] + y, inCircle.centre[1] + x));
-			DrawPoint2D(Vector2(inCircle.centre[0] - y, inCircle.centre[1] + x));
-			DrawPoint2D(Vector2(inCircle.centre[0] - x, inCircle.centre[1] + y));
-			DrawPoint2D(Vector2(inCircle.centre[0] - x, inCircle.centre[1] - y));
-			DrawPoint2D(Vector2(inCircle.centre[0] - y, inCircle.centre[1] - x));
-			DrawPoint2D(Vector2(inCircle.centre[0] + y, inCircle.centre[1] - x));
-			DrawPoint2D(Vector2(inCircle.centre[0] + x, inCircle.centre[1] - y));
+			PlotPoint2D(Vector2(inCircle.centre[0] + x, inCircle.centre[1] + y));
+			PlotPoint2D(Vector2(inCircle.centre[0] + y, inCircle.centre[1] + x));
+			PlotPoint2D(Vector2(inCircle.centre[0] - y, inCircle.centre[1] + x));
+			PlotPoint2D(Vector2(inCircle.centre[0] - x, inCircle.centre[1] + y));
+			PlotPoint2D(Vector2(inCircle.centre[0] - x, inCircle.centre[1] - y));
+			PlotPoint2D(Vector2(inCircle.centre[0] - y, inCircle.centre[1] - x));
+			PlotPoint2D(Vector2(inCircle.centre[0] + y, inCircle.centre[1] - x));
+			PlotPoint2D(Vector2(inCircle.centre[0] + x, inCircle.centre[1] - y));
 		}
 
 		if (err <= 0) {
@@ -11,6 +11,15 @@
 #include <vector>
 #include "Framebuffer.h"
 #include "Vector2.h"
+#include "RasterStats.h"
+#include "CoverageAccumulator.h"
+#include "EdgeBucket.h"
+#include "Texture.h"
+#include "LayerBuffer.h"
+#include "SpanList.h"
+#include "ShapeCache.h"
+#include "Transform2D.h"
+#include "PolygonSimplifier.h"
 
 //Struct representing an entry to the scanline lookup table
 typedef struct _ScanlineLUTItem
@@ -22,6 +31,21 @@ typedef struct _ScanlineLUTItem
 //typedef a scanline as a dynamic array of ScanlineLUTItem
 typedef std::vector<ScanlineLUTItem> Scanline;
 
+//Struct representing an edge crossing a sample row in scanline filling
+typedef struct _SampleCrossing
+{
+	float x;				//the x position where the edge crosses the sample row
+	int winding;			//+1 for an upward edge, -1 for a downward edge
+} SampleCrossing;
+
+//struct representing an affine mapping from framebuffer positions to texture coordinates
+typedef struct _TextureMapping
+{
+	float u, v;				//texture coordinate at the framebuffer origin
+	float dudx, dvdx;		//change of the texture coordinate per pixel along x
+	float dudy, dvdy;		//change of the texture coordinate per pixel along y
+} TextureMapping;
+
 //struct represent a axis-aligned clip rectangle
 typedef struct _ClipRect
 {
@@ -53,7 +77,46 @@ public:
 		ALPHA_BLEND					//alpha blending, e.g. translucency 
 	};
 
+	//enum for anti-aliasing mode
+	enum AntialiasMode {
+		NO_ANTIALIAS = 0,			//aliased rasterisation
+		ANALYTIC_ANTIALIAS,			//per-pixel coverage computed analytically and blended with the framebuffer
+		MULTISAMPLE_ANTIALIAS		//coverage evaluated at the framebuffer's sample positions, resolved by ResolveMultisample()
+	};
+
+	//enum for the polygon fill rule
+	enum FillRule {
+		EVEN_ODD = 0,				//a point is inside if a ray from it crosses the outline an odd number of times
+		NON_ZERO					//a point is inside if the outline winds around it a non-zero number of times
+	};
+
+	//enum for occlusion culling
+	enum OcclusionMode {
+		NO_OCCLUSION = 0,			//every primitive paints all of its pixels
+		LAYER_OCCLUSION				//aliased fills skip pixels covered by an opaque primitive of a nearer or equal layer
+	};
+
+	//enum for the use of the framebuffer's stencil plane
+	enum StencilMode {
+		NO_STENCIL = 0,				//the stencil is neither tested nor written
+		STENCIL_WRITE,				//primitives write the stencil value into the stencil instead of drawing colour
+		STENCIL_TEST				//primitives only draw the pixels whose stencil equals the stencil value
+	};
+
 private:
+	//enum for the result of testing a primitive's bounds against the clip rectangle
+	enum ClipResult {
+		CLIP_OUTSIDE = 0,		//no pixel of the primitive can be drawn
+		CLIP_PARTIAL,			//some pixels may need clipping
+		CLIP_INSIDE				//every pixel lies inside the clip rectangle and no pixel needs the clip or bounds tests
+	};
+
+	//enum for the kinds of shape held by the shape cache, the first value of every key
+	enum ShapeKind {
+		POLYGON_SHAPE = 0,
+		CIRCLE_SHAPE
+	};
+
 	Colour4			mFGColour;		//default foreground colour
 	Colour4			mBGColour;		//default background colour
 	ClipRect		mClipRect;		//current clip region
@@ -61,9 +124,42 @@ private:
 	Scanline		*mScanlineLUT;	//Lookup table for scanline filling
 	int				mWidth;			//Width of the framebuffer
 	int				mHeight;		//Height of the framebuffer
+	int				mPitch;			//Distance between two framebuffer rows in pixels
 	GeometryMode	mGeometryMode;	//current geometry rasterisation mode 
 	FillMode		mFillMode;		//current fill mode
 	BlendMode		mBlendMode;		//current blend mode
+	AntialiasMode	mAntialiasMode;	//current anti-aliasing mode
+	FillRule		mFillRule;		//current polygon fill rule
+	OcclusionMode	mOcclusionMode;	//current occlusion mode
+	int				mLayer;			//layer of the primitives being drawn, larger is nearer
+	LayerBuffer		mLayerBuffer;	//nearest opaque layer per pixel, sized when LAYER_OCCLUSION is first set
+	StencilMode		mStencilMode;	//current stencil mode
+	unsigned char	mStencilValue;	//value written or tested by the stencil modes
+	std::vector<StencilRun> mMaskRuns;	//scratch storage for the unmasked runs of a span
+	SpanList		*mCapture;		//list receiving the spans of the primitives instead of the framebuffer, NULL when not capturing
+	ShapeCache		mShapeCache;	//spans of recently drawn polygons and circles, disabled until given a size
+	std::vector<float> mShapeKey;	//scratch storage for the key of the shape being drawn
+	std::vector<Vertex2d> mCachedVertices;	//scratch storage for a cached polygon moved to the origin of its spans
+	std::vector<float> mCoverage;	//scratch storage for per-pixel coverage
+	CoverageAccumulator mAccumulator;	//signed-area accumulation buffer for anti-aliased fills
+	std::vector<EdgeBucket> mEdgeTable;		//edges of the polygon being filled, sorted by yMin
+	std::vector<int> mActiveEdges;			//indices into mEdgeTable of the edges that may cross the current sample row
+	int				mNextEdge;		//first edge in mEdgeTable not yet added to mActiveEdges
+	std::vector<SampleCrossing> mCrossings;	//edge crossings of the current sample row sorted by x
+	std::vector<unsigned char> mSampleMasks;	//scratch storage for the per-pixel sample coverage of a row
+	const Texture	*mTexture;		//texture sampled by textured fills, not owned by the rasterizer
+	std::vector<PixelRGBA> mSpanColours;	//scratch storage for the sampled colours of a span
+	bool			mInsideClip;	//the primitive being drawn was accepted as a whole by ClassifyBounds
+	Transform2D		mTransform;		//current transform from the positions of the primitives to the framebuffer
+	bool			mIdentityTransform;	//mTransform is the identity, positions are used as given
+	std::vector<Transform2D> mTransformStack;	//transforms saved by PushTransform()
+	std::vector<Vertex2d> mTransformedVertices;	//scratch storage for the transformed vertices of a primitive
+	float			mSimplifyTolerance;	//largest error in pixels of simplified filled polygons, 0 disables simplification
+	PolygonSimplifier mSimplifier;	//simplifies the contours of filled polygons
+	std::vector<Vertex2d> mSimplifiedVertices;	//scratch storage for the simplified contours of a polygon
+	std::vector<int> mSimplifiedCounts;		//scratch storage for the vertex counts of the simplified contours
+	RasterStats		mStats;			//counters of the frame being drawn
+	RasterStats		mLastFrameStats;	//counters of the previous frame, captured by Clear()
 
 	Rasterizer(void);				//prevent default constructor from being directly invoked
 
@@ -79,6 +175,7 @@ private:
 	//inputs:	v1 and v2 are the end points of an input line segment
 	//			clipRect is the rectangular clip region 
 	//outputs: outP1 and outP2 are the end points of the output clipped line
+	//			false if the line lies entirely outside the clip region
 	bool ClipLine(const Vertex2d &v1, const Vertex2d &v2, const ClipRect& clipRect, Vector2 &outP1, Vector2 &outP2);
 
 	//Method for writing a given colour to the framebuffer
@@ -87,6 +184,189 @@ private:
 	//			const Colour4& rgba --- the RGBA colour to be written to the framebuffer;
 	void WriteRGBAToFramebuffer(int x, int y, const Colour4& colour);
 
+	//Map the positions of vertices to the framebuffer with the current transform
+	//output:	the vertices themselves if the transform is the identity, otherwise their transformed copy,
+	//			which is valid until the next call
+	const Vertex2d* TransformVertices(const Vertex2d* vertices, int count);
+
+	//Simplify the contours of a filled polygon in framebuffer positions within the simplify tolerance
+	//input:	vertices, contourCounts, contourCount --- as the compound ScanlineFillPolygon2D
+	//output:	the simplified vertices and contourCounts, valid until the next call; count receives their total
+	const Vertex2d* SimplifyContours(const Vertex2d* vertices, const int* &contourCounts, int contourCount, int &count);
+
+	//Write or blend the foreground colour into the pixel containing a framebuffer position
+	//Every rasterisation routine plots its pixels through here, DrawPoint2D transforms its point first
+	void PlotPoint2D(const Vector2& pt);
+
+	//Test the bounds of a primitive against the clip rectangle, or the framebuffer while capturing, before rasterizing it
+	//input:	float minX, float maxX, float minY, float maxY --- bounds of the primitive's positions
+	//			float margin --- distance its pixels may reach past the bounds, e.g. half the thickness of a line
+	//output:	CLIP_INSIDE is only returned outside STENCIL_TEST mode, as the stencil still masks pixels;
+	//			culled and accepted primitives are counted in the frame stats
+	ClipResult ClassifyBounds(float minX, float maxX, float minY, float maxY, float margin);
+
+	//Get the rows [bottom, top) primitives may draw to, the rows of the clip rectangle inside the framebuffer
+	//or every framebuffer row while capturing
+	void GetClipRows(int &bottom, int &top) const;
+
+	//Check if the clip rectangle or the stencil can mask pixels, or the stencil is being written
+	inline bool IsMaskActive() const
+	{
+		return mStencilMode != NO_STENCIL ||
+			(!mInsideClip && (mClipRect.left > 0 || mClipRect.bottom > 0 || mClipRect.right < mWidth || mClipRect.top < mHeight));
+	}
+
+	//Check if a pixel inside the framebuffer is outside the clip rectangle or fails the stencil test
+	inline bool IsMasked(int x, int y) const
+	{
+		return x < mClipRect.left || x >= mClipRect.right || y < mClipRect.bottom || y >= mClipRect.top ||
+			(mStencilMode == STENCIL_TEST && mFramebuffer->GetStencil(x, y) != mStencilValue);
+	}
+
+	//Intersect the pixels [x0, x1) of a row with the clip rectangle and, in STENCIL_TEST mode, the stencil runs
+	//output:	the unmasked runs in increasing x, valid until the next call
+	const std::vector<StencilRun> &MaskRuns(int y, int x0, int x1);
+
+	//Build the edge table of a compound polygon and reset the active edge list
+	//inputs are the same as the compound ScanlineFillPolygon2D
+	void BuildEdgeTable(const Vertex2d* vertices, const int* contourCounts, int contourCount);
+
+	//Advance the active edge list to a sample row and gather the crossings of the row into mCrossings
+	//Sample rows must be visited in increasing y after BuildEdgeTable
+	//input:	float sampleY --- y position of the sample row
+	void GatherCrossings(float sampleY);
+
+	//Check if a winding number counts as inside under the current fill rule
+	inline bool IsInside(int winding) const
+	{
+		return mFillRule == EVEN_ODD ? (winding & 1) != 0 : winding != 0;
+	}
+
+	//Drop the per-sample storage of the multisampled pixels [x0, x1) of a row before an aliased write covers them
+	void CollapseSamples(int y, int x0, int x1);
+
+	//Write or blend a colour into the pixels [x0, x1) of a row, split into the runs of the framebuffer layout
+	//Multisampled pixels must have been collapsed by the caller
+	void WriteSolidRun(int y, int x0, int x1, const Colour4& colour);
+
+	//Blend a colour by a constant factor into the pixels [x0, x1) of a row, split into the runs of the framebuffer layout
+	//Multisampled pixels must have been collapsed by the caller
+	void BlendSolidRun(int y, int x0, int x1, const Colour4& colour, float factor);
+
+	//Copy or, in ALPHA_BLEND mode, blend source pixels into the pixels [x0, x1) of a row, split into the runs of the framebuffer layout
+	//input:	const PixelRGBA *src --- x1 - x0 source pixels
+	void WritePixelRun(int y, int x0, int x1, const PixelRGBA* src);
+
+	//Blend a colour by per-pixel coverage into a row or column of pixels, split into the runs of the framebuffer layout
+	//input:	int x, int y --- first pixel
+	//			int count --- number of pixels
+	//			bool vertical --- walk up a column instead of along a row
+	//			float alpha --- blend factor multiplied with the coverage
+	//			const float *coverage --- count coverage values in [0,1]
+	void BlendCoverageRun(int x, int y, int count, bool vertical, const Colour4& colour, float alpha, const float* coverage);
+
+	//Fill the polygon in the edge table row by row, sampling every pixel at its centre
+	//input:	float minY, float maxY --- vertical extent of the polygon
+	//			const Colour4 &colour --- the fill colour
+	//			const TextureMapping* mapping --- NULL for a solid fill, otherwise the spans sample the current texture
+	void FillEdgeTable(float minY, float maxY, const Colour4& colour, const TextureMapping* mapping);
+
+	//Write or blend a colour into the pixels [x0, x1) of a row
+	//input:	int y --- row of the span, must be inside the framebuffer
+	//			int x0, int x1 --- first and one past the last pixel of the span, must be inside the framebuffer
+	//			const Colour4 &colour --- the colour to be written
+	void WriteSpan(int y, int x0, int x1, const Colour4& colour);
+
+	//Write or blend a colour into the pixels [x0, x1) x [y0, y1), which must be inside the framebuffer
+	void WriteRect(int x0, int y0, int x1, int y1, const Colour4& colour);
+
+	//Write the stencil value into the pixels [x0, x1) x [y0, y1) inside the clip rectangle, which must be inside the
+	//framebuffer; used by the image copies in STENCIL_WRITE mode, the colour is left untouched
+	void WriteStencilRect(int x0, int y0, int x1, int y1);
+
+	//Write or blend the current texture into the pixels [x0, x1) of a row, each texel blended by its own alpha in ALPHA_BLEND mode
+	//input:	int y, int x0, int x1 --- as WriteSpan
+	//			const TextureMapping &mapping --- texture coordinates of the pixels
+	void WriteTexturedSpan(int y, int x0, int x1, const TextureMapping& mapping);
+
+	//Write the current texture into the pixels [x0, x1) of a row without the occlusion test
+	void WriteTextureRun(int y, int x0, int x1, const TextureMapping& mapping);
+
+	//Write a colour or the current texture into the unmasked pixels of [x0, x1), or the stencil value in STENCIL_WRITE mode
+	//input:	const TextureMapping *mapping --- texture coordinates, NULL to write the colour
+	void WriteMaskedSpan(int y, int x0, int x1, const Colour4& colour, const TextureMapping* mapping);
+
+	//Write a colour or the current texture into the pixels of [x0, x1) that the layer buffer does not hide,
+	//opaque writes set the layer of the pixels they cover; hidden pixels are neither sampled nor written
+	//input:	const TextureMapping *mapping --- texture coordinates, NULL to write the colour
+	void WriteVisibleSpan(int y, int x0, int x1, const Colour4& colour, const TextureMapping* mapping);
+
+	//Check if a primitive with the given bounds is hidden as a whole by the layer buffer
+	//input:	float minX, float maxX, float minY, float maxY --- bounds of the primitive, pixels are covered at their centres
+	//output:	true if occlusion is enabled and no pixel inside the bounds is visible to the current layer
+	bool IsOccluded(float minX, float maxX, float minY, float maxY);
+
+	//Fill a polygon with the path selected by the anti-aliasing and stencil modes, after the occlusion test
+	//input:	vertices, contourCounts, contourCount --- as the compound ScanlineFillPolygon2D
+	//			float minX, float maxX, float minY, float maxY --- bounds of the polygon
+	void RasterizePolygon(const Vertex2d* vertices, const int* contourCounts, int contourCount, float minX, float maxX, float minY, float maxY);
+
+	//Fill a polygon from the shape cache, capturing its spans with RasterizePolygon on a miss
+	//input:	as RasterizePolygon
+	//output:	false if the cache is disabled or cannot hold the polygon, which must then be rasterized directly
+	bool FillCachedPolygon(const Vertex2d* vertices, const int* contourCounts, int contourCount, float minX, float maxX, float minY, float maxY);
+
+	//Draw a circle from the shape cache, capturing its spans with RasterizeCircle2D on a miss
+	//input:	as DrawCircle2D
+	//output:	false if the cache is disabled or cannot hold the circle, which must then be rasterized directly
+	bool FillCachedCircle(const Circle2D& inCircle, bool filled);
+
+	//Bresenham circle rasterisation used by DrawCircle2D
+	//inputs are the same as DrawCircle2D
+	void RasterizeCircle2D(const Circle2D& inCircle, bool filled);
+
+	//Bresenham line rasterisation shared by DrawLine2D and the polygon/circle routines
+	//inputs are the same as DrawLine2D
+	void RasterizeLine2D(const Vertex2d& v1, const Vertex2d& v2, int thickness);
+
+	//Anti-aliased line rasterisation used by DrawLine2D in ANALYTIC_ANTIALIAS mode
+	//Every pixel along the major axis gets the exact coverage of the line's cross-section,
+	//which is then blended with the framebuffer
+	//inputs are the same as DrawLine2D
+	void RasterizeAntialiasedLine2D(const Vertex2d& v1, const Vertex2d& v2, int thickness);
+
+	//Anti-aliased polygon fill used by ScanlineFillPolygon2D in ANALYTIC_ANTIALIAS mode
+	//Edge pixels get their exact area coverage, interior spans are filled solidly
+	//inputs are the same as the compound ScanlineFillPolygon2D
+	void AntialiasedFillPolygon2D(const Vertex2d* vertices, const int* contourCounts, int contourCount);
+
+	//Multisampled polygon fill used by ScanlineFillPolygon2D and DrawLine2D in MULTISAMPLE_ANTIALIAS mode
+	//Every framebuffer sample inside the polygon is written; pixels covered by only some of their samples are expanded
+	//input:	vertices, contourCounts, contourCount --- the polygon as for the compound ScanlineFillPolygon2D,
+	//			in the area convention where pixel (x, y) covers [x, x+1) x [y, y+1)
+	//			const Vertex2d* gradient --- NULL to fill with the colour of the first vertex, otherwise two vertices
+	//			whose colours are interpolated along the axis between their positions
+	void MultisampleFillPolygon2D(const Vertex2d* vertices, const int* contourCounts, int contourCount, const Vertex2d* gradient);
+
+	//Write a row of per-pixel sample masks with a colour and clear the masks
+	//input:	int x, int y --- framebuffer position of the first mask, must be inside the framebuffer
+	//			unsigned char *masks --- bit s of a mask is set if sample s of the pixel is covered
+	//			int count --- number of masks, the row must not extend past the framebuffer
+	//			const Colour4 &colour --- the colour to be written
+	//			const Vertex2d* gradient --- as MultisampleFillPolygon2D
+	void WriteSampleRow(int x, int y, unsigned char* masks, int count, const Colour4& colour, const Vertex2d* gradient);
+
+	//Write a row of coverage values with a colour; fully covered runs are written as solid spans
+	//and partially covered pixels are blended by their coverage
+	//input:	int x, int y --- framebuffer position of the first coverage value, must be inside the framebuffer
+	//			const float *coverage --- coverage values in [0,1]
+	//			int count --- number of coverage values, the row must not extend past the framebuffer
+	//			const Colour4 &colour --- the colour to be written
+	void WriteCoverageRow(int x, int y, const float* coverage, int count, const Colour4& colour);
+
+	//Write a row of coverage values as WriteCoverageRow, without the clip rectangle and stencil
+	void WriteCoverageRun(int x, int y, const float* coverage, int count, const Colour4& colour);
+
 public:
 	Rasterizer(int width, int height);
 
@@ -94,6 +374,7 @@ public:
 
 	inline int Width() { return mWidth; }
 	inline int Height() { return mHeight; }
+	inline int Pitch() { return mPitch; }
 	
 	//Method for clearing the entire framebuffer with a given colour
 	//input:	const Colour4& colour --- the background colour to be used
@@ -116,15 +397,66 @@ public:
 	void DrawUnfilledPolygon2D(const Vertex2d* vertices, int count);
 	
 	//Method for drawing solidly filled 2D polygon
+	//Self-intersecting polygons are filled according to the fill rule set by SetFillRule()
 	//input:	const Vertex2d* vertices --- an array of polygon vertices ordered in counterclock-wise
 	//			int count --- the number of vertices in the array
 	void ScanlineFillPolygon2D(const Vertex2d* vertices, int count);
+
+	//Method for drawing a solidly filled compound polygon made of several closed contours, e.g. an outer ring and its holes
+	//All contours share one edge table and are filled in a single pass according to the fill rule set by SetFillRule();
+	//with EVEN_ODD holes may have any orientation, with NON_ZERO holes must run opposite to their outer ring
+	//input:	const Vertex2d* vertices --- the vertices of all contours, one contour after another
+	//			const int* contourCounts --- the number of vertices of each contour
+	//			int contourCount --- the number of contours
+	void ScanlineFillPolygon2D(const Vertex2d* vertices, const int* contourCounts, int contourCount);
 	
 	//Method for drawing filled 2D polygon using interpolated filling (aka gradient colours)
 	//input:	const Vertex2d* vertices --- an array of polygon vertices ordered in counterclock-wise
 	//			int count --- the number of vertices in the array
 	void ScanlineInterpolatedFillPolygon2D(const Vertex2d* vertices, int count);
 	
+	//Method for filling an axis-aligned rectangle, the rectangle is clipped to the framebuffer
+	//Axis-aligned polygons passed to ScanlineFillPolygon2D take the same path
+	//input:	int left, int bottom --- position of the rectangle's bottom-left pixel
+	//			int width, int height --- size of the rectangle in pixels
+	//			const Colour4 &colour --- the fill colour, blended by its alpha in ALPHA_BLEND mode
+	void FillRect(int left, int bottom, int width, int height, const Colour4& colour);
+
+	//Method for copying an image into the framebuffer, the image is clipped to the framebuffer
+	//In ALPHA_BLEND mode every pixel is blended by its own alpha, otherwise the rows are copied;
+	//in STENCIL_WRITE mode the rectangle the image covers is written into the stencil instead, as by FillRect
+	//input:	int left, int bottom --- framebuffer position of the image's bottom-left pixel
+	//			const PixelRGBA* pixels --- the image, bottom row first
+	//			int width, int height --- size of the image in pixels
+	//			int stride --- distance between two rows of the image in pixels
+	void BlitRect(int left, int bottom, const PixelRGBA* pixels, int width, int height, int stride);
+
+	//Method for copying a rectangle of the framebuffer to another position, the rectangles may overlap
+	//Pixels whose source or destination lies outside the framebuffer are skipped, the destination is clipped to the
+	//clip rectangle and, in STENCIL_TEST mode, the stencil; multisampled source pixels are copied resolved.
+	//In STENCIL_WRITE mode the destination rectangle is written into the stencil instead, as by FillRect
+	//input:	int srcLeft, int srcBottom --- bottom-left pixel of the source rectangle
+	//			int width, int height --- size of the rectangle in pixels
+	//			int dstLeft, int dstBottom --- bottom-left pixel of the destination
+	void CopyRect(int srcLeft, int srcBottom, int width, int height, int dstLeft, int dstBottom);
+
+	//Method for blending a colour through an 8-bit coverage mask, e.g. a cached glyph
+	//Every pixel is blended with the colour by its coverage, scaled by the colour's alpha in ALPHA_BLEND mode
+	//input:	int x, int y --- framebuffer position of the mask's bottom-left pixel, the mask is clipped to the framebuffer
+	//			const unsigned char* mask --- coverage values from 0 to 255, bottom row first
+	//			int width, int height --- size of the mask in pixels
+	//			int stride --- distance between two rows of the mask
+	//			const Colour4 &colour --- the colour to be blended
+	void BlitCoverageMask(int x, int y, const unsigned char* mask, int width, int height, int stride, const Colour4& colour);
+
+	//Method for drawing a polygon filled with the current texture
+	//Texture coordinates are taken from the vertices' uv and vary affinely across the polygon, which is exact for
+	//triangles and for any polygon whose uv is an affine image of its positions, e.g. rectangles and sprites.
+	//Axis-aligned rectangles skip the edge table. Only aliased filling is supported.
+	//input:	const Vertex2d* vertices --- an array of polygon vertices ordered in counterclock-wise
+	//			int count --- the number of vertices in the array
+	void ScanlineTexturedFillPolygon2D(const Vertex2d* vertices, int count);
+
 	//Method for drawing a 2D circle either filled or unfill based on the value of bool filled
 	//input:	const Circle2D& inCircle --- a 2D circle
 	//			bool filled --- indicate if the circle is draw as filled or unfilled
@@ -147,7 +479,10 @@ public:
 		mBGColour = colour;
 	}
 
-	//Method for setting the rectangular clip region
+	//Method for setting the rectangular clip region, every primitive is clipped to it
+	//Primitives whose bounds lie outside the region are rejected before rasterization, those inside it skip per-pixel clipping
+	//input:	int left, int right --- first and one past the last visible column
+	//			int bottom, int top --- first and one past the last visible row
 	inline void SetClipRectangle(int left, int right, int bottom, int top)
 	{
 		mClipRect.left = left;
@@ -156,6 +491,66 @@ public:
 		mClipRect.top = top;
 	}
 
+	//Getter method for the current clip region
+	inline const ClipRect& GetClipRectangle() const
+	{
+		return mClipRect;
+	}
+
+	//Set the current transform, which maps the positions of the following points, lines, polygons and circles
+	//to the framebuffer before they are clipped, e.g. a pan and zoom of a whole scene in one change.
+	//Circles keep their shape with the radius scaled by Transform2D::ScaleFactor(); line thickness, point size,
+	//rectangles, blits, coverage masks, span lists and text stay in framebuffer pixels.
+	inline void SetTransform(const Transform2D& transform)
+	{
+		mTransform = transform;
+		mIdentityTransform = transform.IsIdentity();
+	}
+
+	//Compose a transform with the current one, applied before it, e.g. the placement of a part within a scene
+	inline void MultiplyTransform(const Transform2D& transform)
+	{
+		SetTransform(mTransform * transform);
+	}
+
+	//Getter method for the current transform
+	inline const Transform2D& GetTransform() const
+	{
+		return mTransform;
+	}
+
+	//Save the current transform, the matching PopTransform() restores it
+	inline void PushTransform()
+	{
+		mTransformStack.push_back(mTransform);
+	}
+
+	//Restore the transform saved by the last PushTransform(), or the identity if none is saved
+	inline void PopTransform()
+	{
+		if (mTransformStack.empty()) {
+			SetTransform(Transform2D());
+			return;
+		}
+
+		SetTransform(mTransformStack.back());
+		mTransformStack.pop_back();
+	}
+
+	//Set the largest distance in pixels between the outline of a filled polygon and the vertices dropped from it
+	//Contours of solidly filled polygons are simplified after the transform and before edge setup, so the edge
+	//table tracks the complexity on screen rather than in the source, e.g. a detailed coastline seen from afar.
+	//Interpolated, textured and unfilled polygons keep every vertex. 0, the default, disables simplification.
+	inline void SetSimplifyTolerance(float pixels)
+	{
+		mSimplifyTolerance = pixels > 0.0f ? pixels : 0.0f;
+	}
+
+	inline float GetSimplifyTolerance() const
+	{
+		return mSimplifyTolerance;
+	}
+
 	//Getter method for current foreground colour
 	inline Colour4 GetCurrentFGColour()
 	{
@@ -168,6 +563,19 @@ public:
 		return mBGColour;
 	}
 
+	//Getter method for the counters of the frame currently being drawn
+	//Counters are only collected when TINYRASTER_ENABLE_STATS is defined
+	inline const RasterStats& GetFrameStats() const
+	{
+		return mStats;
+	}
+
+	//Getter method for the counters of the previous frame, i.e. everything drawn before the last Clear()
+	inline const RasterStats& GetLastFrameStats() const
+	{
+		return mLastFrameStats;
+	}
+
 	//Getter method for current geometry mode
 	inline void SetGeometryMode(GeometryMode mode)
 	{
@@ -185,5 +593,116 @@ public:
 	{
 		mBlendMode = mode;
 	}
+
+	//Setter method for current anti-aliasing mode
+	inline void SetAntialiasMode(AntialiasMode mode)
+	{
+		mAntialiasMode = mode;
+	}
+
+	//Getter method for current anti-aliasing mode
+	inline AntialiasMode GetAntialiasMode()
+	{
+		return mAntialiasMode;
+	}
+
+	//Set the number of framebuffer samples per pixel used in MULTISAMPLE_ANTIALIAS mode
+	//input:	int count --- 1, 4 or 8; changing the count discards the stored samples
+	inline void SetSampleCount(int count)
+	{
+		mFramebuffer->SetSampleCount(count);
+	}
+
+	//Average the samples of the multisampled pixels into the framebuffer's colour buffer,
+	//call after drawing and before reading the framebuffer
+	//input:	int threads --- number of worker threads, 0 picks the number of hardware threads
+	inline void ResolveMultisample(int threads = 0)
+	{
+		mFramebuffer->Resolve(threads);
+	}
+
+	//Setter method for the texture used by ScanlineTexturedFillPolygon2D, the texture must outlive its use
+	inline void SetTexture(const Texture* texture)
+	{
+		mTexture = texture;
+	}
+
+	//Setter method for current polygon fill rule
+	inline void SetFillRule(FillRule rule)
+	{
+		mFillRule = rule;
+	}
+
+	//Setter method for current occlusion mode, enabling occlusion resets the layer buffer
+	//With LAYER_OCCLUSION opaque primitives should be drawn front to back, nearest layer first;
+	//primitives drawn in NO_BLEND mode are opaque, blended primitives are tested but never hide others.
+	//Anti-aliased fills, lines and circles are not affected.
+	void SetOcclusionMode(OcclusionMode mode);
+
+	inline OcclusionMode GetOcclusionMode()
+	{
+		return mOcclusionMode;
+	}
+
+	//Setter method for current stencil mode, the stencil plane is allocated and cleared to 0 on first use
+	//In STENCIL_WRITE mode filled polygons and rectangles are rendered aliased into the stencil, whatever the
+	//anti-aliasing mode; lines and points write the stencil of the pixels they would draw, BlitRect and CopyRect
+	//the stencil of their destination rectangle.
+	void SetStencilMode(StencilMode mode);
+
+	inline StencilMode GetStencilMode()
+	{
+		return mStencilMode;
+	}
+
+	//Setter method for the value written in STENCIL_WRITE mode and compared in STENCIL_TEST mode
+	inline void SetStencilValue(unsigned char value)
+	{
+		mStencilValue = value;
+	}
+
+	//Set every stencil value
+	inline void ClearStencil(unsigned char value)
+	{
+		mFramebuffer->ClearStencil(value);
+	}
+
+	//Start recording the pixels covered by the following primitives into a span list instead of drawing them
+	//Every primitive except BlitRect and CopyRect is recorded with its coverage, clipped to the framebuffer but not
+	//to the clip rectangle or stencil; colours, textures and the occlusion test are ignored while capturing.
+	//input:	SpanList *spans --- the list, cleared first; it must outlive the capture
+	void BeginSpanCapture(SpanList* spans);
+
+	//Stop recording and finish the span list passed to BeginSpanCapture
+	void EndSpanCapture();
+
+	//Set the number of polygons and circles whose spans are kept for replay, 0 disables the shape cache
+	//A filled polygon or circle drawn again with the same shape, modes and fractional position, anywhere inside
+	//the framebuffer, replays the cached spans instead of being rasterized. Multisampled polygons, blended circles
+	//and anti-aliased polygons in LAYER_OCCLUSION mode are always rasterized.
+	inline void SetShapeCacheSize(int entries)
+	{
+		mShapeCache.SetCapacity(entries);
+	}
+
+	//Getter method for the shape cache, e.g. for its hit and miss counters
+	inline const ShapeCache& GetShapeCache() const
+	{
+		return mShapeCache;
+	}
+
+	//Method for filling a captured or constructed span list with a colour
+	//Fully covered spans are drawn as aliased fills, partially covered ones are blended by their coverage;
+	//the spans are clipped to the framebuffer, the clip rectangle and, in STENCIL_TEST mode, the stencil.
+	//input:	const SpanList &spans --- a finished span list
+	//			int dx, int dy --- offset added to every span
+	//			const Colour4 &colour --- the fill colour, blended by its alpha in ALPHA_BLEND mode
+	void FillSpans(const SpanList& spans, int dx, int dy, const Colour4& colour);
+
+	//Setter method for the layer of the following primitives, larger layers are nearer
+	inline void SetLayer(int layer)
+	{
+		mLayer = layer;
+	}
 };
 
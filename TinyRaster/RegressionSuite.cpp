@@ -0,0 +1,833 @@
+//the reference image I/O uses the portable stdio functions rather than the _s variants
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "RegressionSuite.h"
+#include "AssignmentTests.h"
+#include "SceneGenerator.h"
+#include "PixelConverter.h"
+#include "SceneIndex.h"
+#include "SceneGraph.h"
+#include "Transform2D.h"
+
+namespace RegressionSuite
+{
+	typedef void(*SceneFunction)(Rasterizer *rasterizer);
+
+	//enum for the rasterizer configuration a scene is rendered in
+	enum SceneMode {
+		DEFAULT_MODE = 0,			//aliased, linear layout, no shape cache and the identity transform
+		ANALYTIC_MODE,				//ANALYTIC_ANTIALIAS
+		MULTISAMPLE_MODE,			//4x MULTISAMPLE_ANTIALIAS, resolved after every render
+		TILED_MODE,					//tiled framebuffer layout
+		SHAPE_CACHE_MODE,			//shape cache enabled, every render after the first replays the cached shapes
+		TRANSFORM_MODE				//scene rotated and scaled about the centre of the framebuffer
+	};
+
+	//struct describing one regression scene
+	typedef struct _Scene
+	{
+		const char *name;				//file name stem of the reference image
+		SceneFunction draw;				//function drawing the scene
+		SceneMode mode;					//rasterizer configuration the scene is rendered in
+	} Scene;
+
+	static const int WIDTH = 1280;					//same resolution as the test application
+	static const int HEIGHT = 720;
+	static const int ITERATIONS = 15;				//renders per scene, the median time is used
+	static const int CHANNEL_TOLERANCE = 2;			//max difference of an 8 bit channel before a pixel mismatches
+	static const double MISMATCH_TOLERANCE = 0.001;	//max fraction of mismatching pixels
+	static const double BUDGET_HEADROOM = 3.0;		//recorded budget relative to the measured time, generous enough to hold on other machines
+	static const double BUDGET_SLACK = 0.25;		//slack added to every budget, in units of the calibration time
+	static const int SHAPE_CACHE_SIZE = 256;		//shape cache entries in SHAPE_CACHE_MODE, as in the test application
+	static const int COASTLINE_VERTICES = 6000;		//vertices of the simplified coastline, a fraction of a pixel apart
+	static const float PI = 3.14159265f;
+	static const int ASSIGNMENT_TEST_COUNT = 8;
+	static const int SCENE_GRAPH_FRAMES = 20;			//updates of an animated scene graph, every 5th is compared with a full redraw
+	static const float REPLAY_TOLERANCE = 1.0f / 1024.0f;	//max difference of a colour channel between a cached replay and a rasterized shape
+
+	//Draw Test 06 and Test 08 through a star-shaped stencil and a clip rectangle inside the framebuffer
+	static void StencilClipScene(Rasterizer *rasterizer)
+	{
+		Vertex2d star[10];
+
+		for (int i = 0; i < 10; i++)
+		{
+			float angle = i * 0.2f * PI;
+			float radius = i % 2 ? 150.0f : 360.0f;
+
+			star[i].colour = Colour4(1.0f, 1.0f, 1.0f, 1.0f);
+			star[i].position = Vector2(0.5f * WIDTH + radius * sinf(angle), 0.5f * HEIGHT + radius * cosf(angle));
+		}
+
+		rasterizer->ClearStencil(0);
+		rasterizer->SetStencilValue(1);
+		rasterizer->SetStencilMode(Rasterizer::STENCIL_WRITE);
+		rasterizer->ScanlineFillPolygon2D(star, 10);
+
+		rasterizer->SetStencilMode(Rasterizer::STENCIL_TEST);
+		rasterizer->SetClipRectangle(WIDTH / 8, WIDTH * 7 / 8, HEIGHT / 8, HEIGHT * 7 / 8);
+		AssignmentTests::AssignmentTest06(rasterizer);
+		AssignmentTests::AssignmentTest08(rasterizer);
+
+		rasterizer->SetStencilMode(Rasterizer::NO_STENCIL);
+		rasterizer->SetClipRectangle(0, WIDTH, 0, HEIGHT);
+	}
+
+	//Fill a generated coastline whose vertices lie a fraction of a pixel apart, simplified with a half pixel tolerance
+	static void SimplifyScene(Rasterizer *rasterizer)
+	{
+		std::vector<Vertex2d> coastline(COASTLINE_VERTICES);
+
+		for (int i = 0; i < COASTLINE_VERTICES; i++)
+		{
+			float angle = i * 2.0f * PI / COASTLINE_VERTICES;
+			float radius = 250.0f + 40.0f * sinf(7.0f * angle) + 15.0f * sinf(31.0f * angle) + 5.0f * sinf(173.0f * angle);
+
+			coastline[i].colour = Colour4(0.2f, 0.6f, 0.3f, 1.0f);
+			coastline[i].position = Vector2(0.5f * WIDTH + radius * cosf(angle), 0.5f * HEIGHT + radius * sinf(angle));
+		}
+
+		rasterizer->SetGeometryMode(Rasterizer::POLYGON);
+		rasterizer->SetFillMode(Rasterizer::SOLID_FILLED);
+		rasterizer->SetSimplifyTolerance(0.5f);
+		rasterizer->ScanlineFillPolygon2D(&coastline[0], COASTLINE_VERTICES);
+		rasterizer->SetSimplifyTolerance(0.0f);
+	}
+
+	//Test 03 and Test 07 are only rendered aliased, unfilled and interpolated polygons are never anti-aliased
+	static const Scene sScenes[] = {
+		{ "test01", AssignmentTests::AssignmentTest01, DEFAULT_MODE },
+		{ "test02", AssignmentTests::AssignmentTest02, DEFAULT_MODE },
+		{ "test03", AssignmentTests::AssignmentTest03, DEFAULT_MODE },
+		{ "test04", AssignmentTests::AssignmentTest04, DEFAULT_MODE },
+		{ "test05", AssignmentTests::AssignmentTest05, DEFAULT_MODE },
+		{ "test06", AssignmentTests::AssignmentTest06, DEFAULT_MODE },
+		{ "test07", AssignmentTests::AssignmentTest07, DEFAULT_MODE },
+		{ "test08", AssignmentTests::AssignmentTest08, DEFAULT_MODE },
+		{ "analytic01", AssignmentTests::AssignmentTest01, ANALYTIC_MODE },
+		{ "analytic02", AssignmentTests::AssignmentTest02, ANALYTIC_MODE },
+		{ "analytic04", AssignmentTests::AssignmentTest04, ANALYTIC_MODE },
+		{ "analytic05", AssignmentTests::AssignmentTest05, ANALYTIC_MODE },
+		{ "analytic06", AssignmentTests::AssignmentTest06, ANALYTIC_MODE },
+		{ "analytic08", AssignmentTests::AssignmentTest08, ANALYTIC_MODE },
+		{ "msaa01", AssignmentTests::AssignmentTest01, MULTISAMPLE_MODE },
+		{ "msaa02", AssignmentTests::AssignmentTest02, MULTISAMPLE_MODE },
+		{ "msaa04", AssignmentTests::AssignmentTest04, MULTISAMPLE_MODE },
+		{ "msaa05", AssignmentTests::AssignmentTest05, MULTISAMPLE_MODE },
+		{ "msaa06", AssignmentTests::AssignmentTest06, MULTISAMPLE_MODE },
+		{ "msaa08", AssignmentTests::AssignmentTest08, MULTISAMPLE_MODE },
+		{ "tiled06", AssignmentTests::AssignmentTest06, TILED_MODE },
+		{ "tiled08", AssignmentTests::AssignmentTest08, TILED_MODE },
+		{ "stencil_clip", StencilClipScene, DEFAULT_MODE },
+		{ "stencil_clip_analytic", StencilClipScene, ANALYTIC_MODE },
+		{ "shape_cache04", AssignmentTests::AssignmentTest04, SHAPE_CACHE_MODE },
+		{ "shape_cache08", AssignmentTests::AssignmentTest08, SHAPE_CACHE_MODE },
+		{ "transform05", AssignmentTests::AssignmentTest05, TRANSFORM_MODE },
+		{ "transform08", AssignmentTests::AssignmentTest08, TRANSFORM_MODE },
+		{ "simplify", SimplifyScene, DEFAULT_MODE }
+	};
+
+	static const int SCENE_COUNT = sizeof(sScenes) / sizeof(Scene);
+
+	//Put a new rasterizer into the configuration of a scene mode
+	static void ConfigureScene(Rasterizer *rasterizer, SceneMode mode)
+	{
+		switch (mode)
+		{
+		case ANALYTIC_MODE:
+			rasterizer->SetAntialiasMode(Rasterizer::ANALYTIC_ANTIALIAS);
+			break;
+		case MULTISAMPLE_MODE:
+			rasterizer->SetSampleCount(4);
+			rasterizer->SetAntialiasMode(Rasterizer::MULTISAMPLE_ANTIALIAS);
+			break;
+		case TILED_MODE:
+			rasterizer->GetFrameBuffer()->SetLayout(Framebuffer::TILED);
+			break;
+		case SHAPE_CACHE_MODE:
+			rasterizer->SetShapeCacheSize(SHAPE_CACHE_SIZE);
+			break;
+		case TRANSFORM_MODE:
+			rasterizer->SetTransform(Transform2D::Translation(0.5f * WIDTH, 0.5f * HEIGHT) * Transform2D::Rotation(0.3f) *
+				Transform2D::Scale(0.8f, 0.8f) * Transform2D::Translation(-0.5f * WIDTH, -0.5f * HEIGHT));
+			break;
+		default:
+			break;
+		}
+	}
+
+	//Clear the framebuffer and draw a scene into it, resolving the samples of a multisampled scene
+	static void DrawScene(Rasterizer *rasterizer, const Scene &scene)
+	{
+		rasterizer->Clear(Colour4(0.1f, 0.1f, 0.1f, 1.0f));
+		scene.draw(rasterizer);
+
+		if (scene.mode == MULTISAMPLE_MODE)
+		{
+			rasterizer->ResolveMultisample();
+		}
+	}
+
+	//Render a scene ITERATIONS times in a rasterizer configured for it and return the median time in milliseconds
+	static double RenderScene(Rasterizer *rasterizer, const Scene &scene)
+	{
+		std::vector<double> times;
+
+		ConfigureScene(rasterizer, scene.mode);
+
+		for (int i = 0; i < ITERATIONS; i++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			DrawScene(rasterizer, scene);
+
+			times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		std::sort(times.begin(), times.end());
+
+		return times[ITERATIONS / 2];
+	}
+
+	//Time a fixed workload that does not use the rasterizer, blending a colour into a framebuffer-sized buffer of float
+	//channels; budgets are kept as multiples of this time, so they carry over to machines of a different speed and
+	//a change that slows a scene down does not slow the calibration with it
+	static double CalibrationTime()
+	{
+		std::vector<float> channels(WIDTH * HEIGHT * 4, 0.5f);
+		std::vector<double> times;
+		volatile float sink = 0.0f;
+
+		for (int i = 0; i < ITERATIONS; i++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			for (size_t c = 0; c < channels.size(); c++)
+			{
+				channels[c] = channels[c] * 0.75f + 0.0625f * (float)(c & 3);
+			}
+
+			sink = sink + channels[i];
+			times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		std::sort(times.begin(), times.end());
+
+		return times[ITERATIONS / 2];
+	}
+
+	//Quantise the framebuffer to 8 bit RGBA, top row first
+	static void ReadbackRGBA8(Rasterizer *rasterizer, std::vector<unsigned char> &image)
+	{
+		PixelConverter converter(PixelConverter::RGBA8, PixelConverter::FLIP_ROWS);
+
+		image.resize(WIDTH * HEIGHT * 4);
+		converter.Convert(rasterizer->GetFrameBuffer()->GetView(0, 0, WIDTH, HEIGHT), &image[0], WIDTH * 4);
+	}
+
+	static void ScenePath(char *path, int size, const char *directory, const char *name)
+	{
+		snprintf(path, size, "%s/%s.tga", directory, name);
+	}
+
+	static const int TGA_HEADER_SIZE = 18;
+	static const int TGA_RLE_TRUECOLOUR = 10;		//image type of a run-length encoded true-colour image
+	static const int TGA_TOP_LEFT_32 = 0x28;		//descriptor of 8 alpha bits with the top row first
+	static const int TGA_MAX_PACKET = 128;			//pixels in the longest run or raw packet
+
+	//Write an 8 bit RGBA image, top row first, as a run-length encoded 32 bit TGA file
+	//Most of a regression scene is background, so the references stay small enough to be kept with the sources.
+	static bool WriteImage(const char *path, const std::vector<unsigned char> &image)
+	{
+		FILE *file = fopen(path, "wb");
+
+		if (file == NULL)
+		{
+			return false;
+		}
+
+		unsigned char header[TGA_HEADER_SIZE] = { 0 };
+
+		header[2] = TGA_RLE_TRUECOLOUR;
+		header[12] = WIDTH & 0xff;
+		header[13] = WIDTH >> 8;
+		header[14] = HEIGHT & 0xff;
+		header[15] = HEIGHT >> 8;
+		header[16] = 32;
+		header[17] = TGA_TOP_LEFT_32;
+
+		std::vector<unsigned char> encoded(header, header + TGA_HEADER_SIZE);
+
+		//TGA stores BGRA, packets never cross the end of a row
+		for (int y = 0; y < HEIGHT; y++)
+		{
+			const unsigned char *row = &image[y * WIDTH * 4];
+			int x = 0;
+
+			while (x < WIDTH)
+			{
+				int run = 1;
+
+				while (x + run < WIDTH && run < TGA_MAX_PACKET && memcmp(row + x * 4, row + (x + run) * 4, 4) == 0)
+				{
+					run++;
+				}
+
+				int count = run;
+
+				//a raw packet extends up to the start of the next run of at least two equal pixels
+				if (run == 1)
+				{
+					while (x + count < WIDTH && count < TGA_MAX_PACKET &&
+						(x + count + 1 == WIDTH || memcmp(row + (x + count) * 4, row + (x + count + 1) * 4, 4) != 0))
+					{
+						count++;
+					}
+				}
+
+				encoded.push_back((unsigned char)((run > 1 ? 0x80 : 0x00) | (count - 1)));
+
+				for (int i = 0; i < (run > 1 ? 1 : count); i++)
+				{
+					const unsigned char *pixel = row + (x + i) * 4;
+
+					encoded.push_back(pixel[2]);
+					encoded.push_back(pixel[1]);
+					encoded.push_back(pixel[0]);
+					encoded.push_back(pixel[3]);
+				}
+
+				x += count;
+			}
+		}
+
+		bool ok = fwrite(&encoded[0], 1, encoded.size(), file) == encoded.size();
+
+		return fclose(file) == 0 && ok;
+	}
+
+	//Read an 8 bit RGBA image, top row first, from a TGA file written by WriteImage
+	static bool ReadImage(const char *path, std::vector<unsigned char> &image)
+	{
+		FILE *file = fopen(path, "rb");
+
+		if (file == NULL)
+		{
+			return false;
+		}
+
+		unsigned char header[TGA_HEADER_SIZE];
+		bool ok = fread(header, 1, TGA_HEADER_SIZE, file) == TGA_HEADER_SIZE && header[0] == 0 && header[1] == 0 &&
+			header[2] == TGA_RLE_TRUECOLOUR && header[12] + (header[13] << 8) == WIDTH && header[14] + (header[15] << 8) == HEIGHT &&
+			header[16] == 32 && header[17] == TGA_TOP_LEFT_32;
+
+		image.resize(WIDTH * HEIGHT * 4);
+
+		int pixel = 0;
+
+		while (ok && pixel < WIDTH * HEIGHT)
+		{
+			int packet = fgetc(file);
+			int count = (packet & 0x7f) + 1;
+			unsigned char bgra[4];
+
+			ok = packet != EOF && pixel + count <= WIDTH * HEIGHT;
+
+			for (int i = 0; ok && i < count; i++, pixel++)
+			{
+				//a run packet holds one colour, a raw packet one colour per pixel
+				if (i == 0 || (packet & 0x80) == 0)
+				{
+					ok = fread(bgra, 1, 4, file) == 4;
+				}
+
+				image[pixel * 4 + 0] = bgra[2];
+				image[pixel * 4 + 1] = bgra[1];
+				image[pixel * 4 + 2] = bgra[0];
+				image[pixel * 4 + 3] = bgra[3];
+			}
+		}
+
+		fclose(file);
+
+		return ok;
+	}
+
+	//Count the pixels whose channels differ by more than CHANNEL_TOLERANCE
+	static int CountMismatches(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b)
+	{
+		int mismatches = 0;
+
+		for (size_t i = 0; i < a.size(); i += 4)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				if (abs((int)a[i + c] - (int)b[i + c]) > CHANNEL_TOLERANCE)
+				{
+					mismatches++;
+					break;
+				}
+			}
+		}
+
+		return mismatches;
+	}
+
+	//Render the scenes drawn in the linear layout again in the tiled layout, whose 8 bit readback must be identical,
+	//and return the number of scenes that differ; this covers the anti-aliased and multisampled writes and the
+	//row reads of the tiled layout, which only differ from the linear ones in where a pixel is stored
+	static int CheckLayouts()
+	{
+		int failures = 0;
+		int comparisons = 0;
+		std::vector<unsigned char> linear;
+		std::vector<unsigned char> tiled;
+
+		for (int i = 0; i < SCENE_COUNT; i++)
+		{
+			const Scene &scene = sScenes[i];
+
+			if (scene.mode != DEFAULT_MODE && scene.mode != ANALYTIC_MODE && scene.mode != MULTISAMPLE_MODE)
+			{
+				continue;
+			}
+
+			Rasterizer linearRasterizer(WIDTH, HEIGHT);
+			Rasterizer tiledRasterizer(WIDTH, HEIGHT);
+
+			ConfigureScene(&linearRasterizer, scene.mode);
+			ConfigureScene(&tiledRasterizer, scene.mode);
+			tiledRasterizer.GetFrameBuffer()->SetLayout(Framebuffer::TILED);
+
+			DrawScene(&linearRasterizer, scene);
+			DrawScene(&tiledRasterizer, scene);
+			ReadbackRGBA8(&linearRasterizer, linear);
+			ReadbackRGBA8(&tiledRasterizer, tiled);
+
+			bool ok = linear == tiled;
+
+			printf("%s tiled: %s\n", scene.name, ok ? "passed, identical to linear" : "FAILED, differs from linear");
+
+			comparisons++;
+			failures += ok ? 0 : 1;
+		}
+
+		printf("%d of %d layout comparisons failed\n", failures, comparisons);
+
+		return failures;
+	}
+
+	//Get the largest difference of a colour channel between the framebuffers of two rasterizers
+	static float MaxDifference(Rasterizer *a, Rasterizer *b)
+	{
+		float difference = 0.0f;
+
+		for (int y = 0; y < HEIGHT; y++)
+		{
+			for (int x = 0; x < WIDTH; x++)
+			{
+				const PixelRGBA &pa = *a->GetFrameBuffer()->GetPixel(x, y);
+				const PixelRGBA &pb = *b->GetFrameBuffer()->GetPixel(x, y);
+
+				for (int c = 0; c < 4; c++)
+				{
+					difference = std::max(difference, fabsf(pa[c] - pb[c]));
+				}
+			}
+		}
+
+		return difference;
+	}
+
+	//Draw the scenes rendered without the shape cache twice with and without it, so the second draw replays the shapes
+	//the first one cached, and return the number of scenes where either draw differs from the uncached one by more
+	//than REPLAY_TOLERANCE in a colour channel or a cached shape is not replayed; both draws are compared as the first
+	//unfilled circle of Test 08 takes the foreground colour left by the draw before it. Shapes partly outside the
+	//framebuffer are captured at the origin of their bounds, the tolerance absorbs the different round-off of their
+	//analytic coverage there. Test 04 must replay its triangle and pentagon, which cross the edges of the framebuffer;
+	//its rectangles take the rectangle fill, which never reaches the cache.
+	static int CheckShapeCache()
+	{
+		int failures = 0;
+		int comparisons = 0;
+
+		for (int i = 0; i < SCENE_COUNT; i++)
+		{
+			const Scene &scene = sScenes[i];
+
+			if (scene.mode != DEFAULT_MODE && scene.mode != ANALYTIC_MODE && scene.mode != MULTISAMPLE_MODE)
+			{
+				continue;
+			}
+
+			Rasterizer uncached(WIDTH, HEIGHT);
+			Rasterizer cached(WIDTH, HEIGHT);
+
+			ConfigureScene(&uncached, scene.mode);
+			ConfigureScene(&cached, scene.mode);
+			cached.SetShapeCacheSize(SHAPE_CACHE_SIZE);
+
+			DrawScene(&uncached, scene);
+			DrawScene(&cached, scene);
+
+			float first = MaxDifference(&uncached, &cached);
+
+			DrawScene(&uncached, scene);
+			DrawScene(&cached, scene);
+
+			float replay = MaxDifference(&uncached, &cached);
+			unsigned long long hits = cached.GetShapeCache().GetHits();
+			bool ok = first <= REPLAY_TOLERANCE && replay <= REPLAY_TOLERANCE && hits >= cached.GetShapeCache().GetMisses() &&
+				(scene.draw != AssignmentTests::AssignmentTest04 || scene.mode == MULTISAMPLE_MODE || hits >= 2);
+
+			printf("%s cached: %s, max difference %g, replayed %g, %llu shapes replayed\n", scene.name, ok ? "passed" : "FAILED",
+				first, replay, hits);
+
+			comparisons++;
+			failures += ok ? 0 : 1;
+		}
+
+		printf("%d of %d shape cache comparisons failed\n", failures, comparisons);
+
+		return failures;
+	}
+
+	//Animate a scene graph holding an assignment test in every anti-aliasing mode, compare every 5th incremental update
+	//with a full redraw of the same graph and return the number of scenes where a compared update mismatches;
+	//the 8 bit tolerance absorbs the rounding of analytic coverage accumulated over a damaged rectangle only
+	static int CheckSceneGraph()
+	{
+		static const SceneMode modes[] = { DEFAULT_MODE, ANALYTIC_MODE, MULTISAMPLE_MODE };
+		static const char *modeNames[] = { "aliased", "analytic", "msaa" };
+		int failures = 0;
+		int comparisons = 0;
+		std::vector<unsigned char> incremental;
+		std::vector<unsigned char> full;
+
+		for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+		{
+			for (int test = 0; test < ASSIGNMENT_TEST_COUNT; test++)
+			{
+				Rasterizer incrementalRasterizer(WIDTH, HEIGHT);
+				Rasterizer fullRasterizer(WIDTH, HEIGHT);
+				SceneBuilder builder;
+				SceneGraph graph;
+
+				ConfigureScene(&incrementalRasterizer, modes[m]);
+				ConfigureScene(&fullRasterizer, modes[m]);
+				AssignmentTests::BuildAssignmentScene(test, builder);
+
+				graph.SetBackground(Colour4(0.1f, 0.1f, 0.1f, 1.0f));
+
+				int scene = graph.AddGroup(-1);
+
+				graph.AddSceneView(scene, builder.GetView());
+
+				//a gradient line and a translucent circle moving over the scene damage a few rectangles per update
+				Vertex2d line[2];
+				Circle2D circle = { Colour4(1.0f, 0.0f, 0.0f, 0.5f), Vector2(50.0f, 50.0f), 30.0f };
+				line[0].colour = Colour4(1.0f, 1.0f, 1.0f, 1.0f);
+				line[0].position = Vector2(640.0f, 360.0f);
+				line[1].colour = Colour4(0.0f, 1.0f, 0.0f, 1.0f);
+				line[1].position = Vector2(100.0f, 100.0f);
+
+				int overlay = graph.AddGroup(-1);
+				int lineNode = graph.AddLines(overlay, line, 2);
+				int circleNode = graph.AddCircles(overlay, &circle, 1, true);
+
+				graph.SetFillMode(lineNode, Rasterizer::INTERPOLATED_FILLED);
+				graph.SetBlendMode(circleNode, Rasterizer::ALPHA_BLEND);
+
+				int mismatches = 0;
+
+				for (int frame = 0; frame < SCENE_GRAPH_FRAMES; frame++)
+				{
+					line[1].position = Vector2(100.0f + frame * 37.3f, 100.0f + frame * 21.1f);
+					graph.SetVertices(lineNode, line, 2);
+					graph.SetTransform(overlay, Transform2D::Translation(frame * 5.0f, frame * 3.0f));
+
+					//the first primitive of the scene blinks, damaging the scene itself
+					graph.SetVisible(scene + 1, frame % 10 < 5);
+					graph.Update(&incrementalRasterizer);
+
+					if (frame % 5 != 4)
+					{
+						continue;
+					}
+
+					SceneGraph redraw = graph;
+
+					redraw.Invalidate();
+					redraw.Update(&fullRasterizer);
+
+					if (modes[m] == MULTISAMPLE_MODE)
+					{
+						incrementalRasterizer.ResolveMultisample();
+						fullRasterizer.ResolveMultisample();
+					}
+
+					ReadbackRGBA8(&incrementalRasterizer, incremental);
+					ReadbackRGBA8(&fullRasterizer, full);
+					mismatches = std::max(mismatches, CountMismatches(incremental, full));
+				}
+
+				bool ok = mismatches == 0;
+
+				printf("test%02d %s scene graph: %s, %d mismatching pixels\n", test + 1, modeNames[m], ok ? "passed" : "FAILED", mismatches);
+
+				comparisons++;
+				failures += ok ? 0 : 1;
+			}
+		}
+
+		printf("%d of %d scene graph comparisons failed\n", failures, comparisons);
+
+		return failures;
+	}
+
+	int Record(const char *directory)
+	{
+		char path[1024];
+		int failures = 0;
+		std::vector<unsigned char> image;
+
+		snprintf(path, sizeof(path), "%s/budgets.txt", directory);
+
+		FILE *budgets = fopen(path, "w");
+
+		if (budgets == NULL)
+		{
+			printf("Cannot write %s\n", path);
+			return SCENE_COUNT;
+		}
+
+		//budgets are written in units of the calibration time, whose value is only kept for reference
+		double calibration = CalibrationTime();
+
+		fprintf(budgets, "calibration_ms %.3f\n", calibration);
+		printf("calibration: %.3f ms\n", calibration);
+
+		for (int i = 0; i < SCENE_COUNT; i++)
+		{
+			Rasterizer rasterizer(WIDTH, HEIGHT);
+			double time = RenderScene(&rasterizer, sScenes[i]);
+			double budget = time * BUDGET_HEADROOM + BUDGET_SLACK * calibration;
+
+			ReadbackRGBA8(&rasterizer, image);
+			ScenePath(path, sizeof(path), directory, sScenes[i].name);
+
+			bool ok = WriteImage(path, image);
+
+			fprintf(budgets, "%s %.3f\n", sScenes[i].name, budget / calibration);
+			printf("%s: %s, %.3f ms, budget %.3f ms\n", sScenes[i].name, ok ? "recorded" : "FAILED to write", time, budget);
+
+			failures += ok ? 0 : 1;
+		}
+
+		fclose(budgets);
+
+		return failures;
+	}
+
+	int Check(const char *directory)
+	{
+		char path[1024];
+		int failures = 0;
+		double budgets[SCENE_COUNT];
+		std::vector<unsigned char> image;
+		std::vector<unsigned char> reference;
+
+		//a missing budget disables the time check of a scene
+		for (int i = 0; i < SCENE_COUNT; i++)
+		{
+			budgets[i] = -1.0;
+		}
+
+		snprintf(path, sizeof(path), "%s/budgets.txt", directory);
+
+		FILE *file = fopen(path, "r");
+		char name[64];
+		double budget;
+
+		while (file && fscanf(file, "%63s %lf", name, &budget) == 2)
+		{
+			for (int i = 0; i < SCENE_COUNT; i++)
+			{
+				if (strcmp(name, sScenes[i].name) == 0)
+				{
+					budgets[i] = budget;
+				}
+			}
+		}
+
+		if (file)
+		{
+			fclose(file);
+		}
+
+		//the budgets are multiples of the calibration time, measured again on this machine
+		double calibration = CalibrationTime();
+
+		printf("calibration: %.3f ms\n", calibration);
+
+		for (int i = 0; i < SCENE_COUNT; i++)
+		{
+			if (budgets[i] >= 0.0)
+			{
+				budgets[i] *= calibration;
+			}
+		}
+
+		for (int i = 0; i < SCENE_COUNT; i++)
+		{
+			Rasterizer rasterizer(WIDTH, HEIGHT);
+			double time = RenderScene(&rasterizer, sScenes[i]);
+
+			ReadbackRGBA8(&rasterizer, image);
+			ScenePath(path, sizeof(path), directory, sScenes[i].name);
+
+			if (!ReadImage(path, reference))
+			{
+				printf("%s: FAILED, cannot read reference %s\n", sScenes[i].name, path);
+				failures++;
+				continue;
+			}
+
+			int mismatches = CountMismatches(image, reference);
+			bool imageOk = mismatches <= MISMATCH_TOLERANCE * WIDTH * HEIGHT;
+			bool timeOk = budgets[i] < 0.0 || time <= budgets[i];
+
+			printf("%s: %s, %d mismatching pixels, %.3f ms (budget %.3f ms)%s\n", sScenes[i].name,
+				imageOk && timeOk ? "passed" : "FAILED", mismatches, time, budgets[i], timeOk ? "" : " over budget");
+
+			failures += imageOk && timeOk ? 0 : 1;
+		}
+
+		printf("%d of %d scenes failed\n", failures, SCENE_COUNT);
+
+		return failures + CheckLayouts() + CheckShapeCache() + CheckSceneGraph();
+	}
+
+	static const int BENCHMARK_ITERATIONS = 5;		//renders per benchmark configuration, the median time is used
+
+	//Generate a stress scene, render it and append one CSV row
+	static void BenchmarkScene(FILE *csv, const char *sweep, int primitives, float size, int width, int height, int overlapDepth)
+	{
+		SceneBuilder builder;
+		StressSceneParams params = SceneGenerator::DefaultParams(primitives, size, width, height);
+		std::vector<double> times;
+
+		params.overlapDepth = overlapDepth;
+		SceneGenerator::Generate(params, builder);
+
+		Rasterizer rasterizer(width, height);
+		SceneView scene = builder.GetView();
+
+		for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			rasterizer.Clear(Colour4(0.1f, 0.1f, 0.1f, 1.0f));
+			DrawSceneView(&rasterizer, scene);
+
+			times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		std::sort(times.begin(), times.end());
+
+		double time = times[BENCHMARK_ITERATIONS / 2];
+
+		fprintf(csv, "%s,%d,%.0f,%d,%d,%d,%.3f,%.0f\n", sweep, primitives, size, width, height, overlapDepth, time, primitives / (time * 0.001));
+		printf("%s: %d primitives, size %.0f, %dx%d, overlap %d: %.3f ms\n", sweep, primitives, size, width, height, overlapDepth, time);
+	}
+
+	//Generate a stress scene over a world several framebuffers wide, render the framebuffer-sized viewport at
+	//its centre through a scene index and append one CSV row; width and height give the size of the world
+	static void BenchmarkWorld(FILE *csv, const char *sweep, int primitives, float size, int scale)
+	{
+		SceneBuilder builder;
+		StressSceneParams params = SceneGenerator::DefaultParams(primitives, size, WIDTH * scale, HEIGHT * scale);
+		std::vector<double> times;
+
+		SceneGenerator::Generate(params, builder);
+
+		Rasterizer rasterizer(WIDTH, HEIGHT);
+		SceneView scene = builder.GetView();
+		SceneIndex index;
+		Transform2D view = Transform2D::Translation(-0.5f * WIDTH * (scale - 1), -0.5f * HEIGHT * (scale - 1));
+
+		index.Build(scene);
+
+		for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			rasterizer.Clear(Colour4(0.1f, 0.1f, 0.1f, 1.0f));
+			index.Draw(&rasterizer, view);
+
+			times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		std::sort(times.begin(), times.end());
+
+		double time = times[BENCHMARK_ITERATIONS / 2];
+
+		fprintf(csv, "%s,%d,%.0f,%d,%d,%d,%.3f,%.0f\n", sweep, primitives, size, WIDTH * scale, HEIGHT * scale, 0, time, primitives / (time * 0.001));
+		printf("%s: %d primitives, size %.0f, %dx%d world: %.3f ms\n", sweep, primitives, size, WIDTH * scale, HEIGHT * scale, time);
+	}
+
+	int Benchmark(const char *csvPath)
+	{
+		FILE *csv = fopen(csvPath, "w");
+
+		if (csv == NULL)
+		{
+			printf("Cannot write %s\n", csvPath);
+			return 1;
+		}
+
+		static const int counts[] = { 100, 1000, 10000, 100000 };
+		static const float sizes[] = { 4.0f, 16.0f, 64.0f, 256.0f };
+		static const int resolutions[][2] = { { 640, 360 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+		static const int overlaps[] = { 1, 2, 4, 8, 16 };
+		static const int worlds[] = { 1, 4, 16 };
+
+		fprintf(csv, "sweep,primitives,size,width,height,overlap,ms,primitives_per_second\n");
+
+		for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+		{
+			BenchmarkScene(csv, "count", counts[i], 32.0f, WIDTH, HEIGHT, 0);
+		}
+
+		for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		{
+			BenchmarkScene(csv, "size", 1000, sizes[i], WIDTH, HEIGHT, 0);
+		}
+
+		for (size_t i = 0; i < sizeof(resolutions) / sizeof(resolutions[0]); i++)
+		{
+			BenchmarkScene(csv, "resolution", 1000, 32.0f, resolutions[i][0], resolutions[i][1], 0);
+		}
+
+		for (size_t i = 0; i < sizeof(overlaps) / sizeof(overlaps[0]); i++)
+		{
+			BenchmarkScene(csv, "overlap", 1000, 64.0f, WIDTH, HEIGHT, overlaps[i]);
+		}
+
+		//the primitive density stays that of the count sweep's 1000 primitives, so only the world grows
+		for (size_t i = 0; i < sizeof(worlds) / sizeof(worlds[0]); i++)
+		{
+			BenchmarkWorld(csv, "world", 1000 * worlds[i] * worlds[i], 32.0f, worlds[i]);
+		}
+
+		return fclose(csv) == 0 ? 0 : 1;
+	}
+}
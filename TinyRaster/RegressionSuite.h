@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Rasterizer.h"
+
+//Headless golden-image and performance regression runner for the assignment test scenes.
+//The scenes are the AssignmentTest0N scenes rendered aliased, with analytic and 4x multisample anti-aliasing,
+//in the tiled layout, through the shape cache and under a transform, plus a stencil and clip rectangle scene and a
+//simplified coastline. Record mode stores every scene as a reference image (name.tga) and records a time budget
+//per scene (budgets.txt) as a multiple of a calibration loop that does not use the rasterizer, so budgets carry
+//over to other machines. Check mode renders the scenes again, compares them with the references within a
+//tolerance and fails scenes that exceed their budget; scenes without a budget only have their image checked.
+//The references and budgets kept in Regression/ are recorded with "-record Regression" and only need recording
+//again when a change is meant to alter the output or the speed of a scene.
+//Benchmark mode renders generated stress scenes to chart throughput against scene complexity.
+namespace RegressionSuite
+{
+	//Render every scene and write the reference images and time budgets into a directory
+	//input:	const char *directory --- existing directory receiving the references
+	//output:	the number of scenes that could not be recorded, 0 on success
+	int Record(const char *directory);
+
+	//Render every scene and compare it with the references in a directory, then compare the tiled layout with
+	//the linear one, which must give identical images, replays of the shape cache with rasterized shapes and
+	//incremental scene graph updates with full redraws
+	//input:	const char *directory --- directory previously passed to Record
+	//output:	the number of scenes that failed the image or the time check plus the number of failed comparisons,
+	//			0 on success
+	int Check(const char *directory);
+
+	//Measure throughput on generated stress scenes, sweeping primitive count, primitive size,
+	//resolution and alpha-blended overlap depth one at a time, then the size of a world drawn through a
+	//SceneIndex viewport, and write the results as CSV
+	//input:	const char *csvPath --- destination CSV file
+	//output:	0 on success
+	int Benchmark(const char *csvPath);
+}
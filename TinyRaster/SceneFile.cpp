@@ -0,0 +1,579 @@
+//the text converter uses the portable stdio functions rather than the _s variants
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "SceneFile.h"
+#include "TraceEvents.h"
+
+//the pools are used in place, so their layout must match the file layout
+static_assert(sizeof(Vertex2d) == 32, "Vertex2d layout does not match the scene file vertex pool");
+static_assert(sizeof(Circle2D) == 28, "Circle2D layout does not match the scene file circle pool");
+static_assert(sizeof(SceneRecord) == 16, "SceneRecord layout does not match the scene file records");
+
+static unsigned long long AlignOffset(unsigned long long offset)
+{
+	return (offset + 15) & ~15ULL;
+}
+
+//true if a section of count elements of the given size starting at offset lies inside a file of fileSize bytes
+//the subtraction keeps a huge offset or count from wrapping around
+static bool SectionFits(unsigned long long offset, unsigned long long count, unsigned long long size, unsigned long long fileSize)
+{
+	return offset <= fileSize && count <= (fileSize - offset) / size;
+}
+
+//true for a value that is neither infinite nor NaN, NaN fails every comparison
+static bool IsFinite(float value)
+{
+	return fabsf(value) <= FLT_MAX;
+}
+
+static bool IsFinite(const Colour4 &colour)
+{
+	return IsFinite(colour[0]) && IsFinite(colour[1]) && IsFinite(colour[2]) && IsFinite(colour[3]);
+}
+
+static bool IsFinite(const Vector2 &position)
+{
+	return IsFinite(position[0]) && IsFinite(position[1]);
+}
+
+void DrawSceneView(Rasterizer *rasterizer, const SceneView &scene)
+{
+	TRACE_SCOPE_ARG("DrawScene", "records", scene.recordCount);
+
+	for (unsigned int i = 0; i < scene.recordCount; i++)
+	{
+		const SceneRecord &record = scene.records[i];
+
+		//first only indexes the vertex pool for the vertex records
+		const Vertex2d *vertices = record.type != SCENE_STATE && record.type != SCENE_CIRCLES ? scene.vertices + record.first : NULL;
+
+		switch (record.type)
+		{
+		case SCENE_STATE:
+			rasterizer->SetGeometryMode((Rasterizer::GeometryMode)record.first);
+			rasterizer->SetFillMode((Rasterizer::FillMode)record.count);
+			rasterizer->SetBlendMode((Rasterizer::BlendMode)record.param);
+			break;
+		case SCENE_LINES:
+			for (unsigned int v = 0; v + 1 < record.count; v += 2)
+			{
+				rasterizer->DrawLine2D(vertices[v], vertices[v + 1], record.param);
+			}
+			break;
+		case SCENE_UNFILLED_POLYGON:
+			rasterizer->DrawUnfilledPolygon2D(vertices, record.count);
+			break;
+		case SCENE_FILLED_POLYGON:
+			rasterizer->ScanlineFillPolygon2D(vertices, record.count);
+			break;
+		case SCENE_INTERPOLATED_POLYGON:
+			rasterizer->ScanlineInterpolatedFillPolygon2D(vertices, record.count);
+			break;
+		case SCENE_CIRCLES:
+			for (unsigned int c = 0; c < record.count; c++)
+			{
+				rasterizer->DrawCircle2D(scene.circles[record.first + c], record.param != 0);
+			}
+			break;
+		}
+	}
+}
+
+void SceneBuilder::AddRecord(SceneRecordType type, unsigned int first, unsigned int count, unsigned int param)
+{
+	SceneRecord record = { (unsigned int)type, first, count, param };
+	mRecords.push_back(record);
+}
+
+void SceneBuilder::Clear()
+{
+	mVertices.clear();
+	mCircles.clear();
+	mRecords.clear();
+}
+
+void SceneBuilder::AddState(Rasterizer::GeometryMode geometry, Rasterizer::FillMode fill, Rasterizer::BlendMode blend)
+{
+	AddRecord(SCENE_STATE, geometry, fill, blend);
+}
+
+void SceneBuilder::AddLines(const Vertex2d *vertices, int count, int thickness)
+{
+	AddRecord(SCENE_LINES, (unsigned int)mVertices.size(), count, thickness);
+	mVertices.insert(mVertices.end(), vertices, vertices + count);
+}
+
+void SceneBuilder::AddUnfilledPolygon(const Vertex2d *vertices, int count)
+{
+	AddRecord(SCENE_UNFILLED_POLYGON, (unsigned int)mVertices.size(), count, 0);
+	mVertices.insert(mVertices.end(), vertices, vertices + count);
+}
+
+void SceneBuilder::AddFilledPolygon(const Vertex2d *vertices, int count)
+{
+	AddRecord(SCENE_FILLED_POLYGON, (unsigned int)mVertices.size(), count, 0);
+	mVertices.insert(mVertices.end(), vertices, vertices + count);
+}
+
+void SceneBuilder::AddInterpolatedPolygon(const Vertex2d *vertices, int count)
+{
+	AddRecord(SCENE_INTERPOLATED_POLYGON, (unsigned int)mVertices.size(), count, 0);
+	mVertices.insert(mVertices.end(), vertices, vertices + count);
+}
+
+void SceneBuilder::AddCircles(const Circle2D *circles, int count, bool filled)
+{
+	AddRecord(SCENE_CIRCLES, (unsigned int)mCircles.size(), count, filled ? 1 : 0);
+	mCircles.insert(mCircles.end(), circles, circles + count);
+}
+
+SceneView SceneBuilder::GetView() const
+{
+	SceneView view;
+
+	view.vertices = mVertices.empty() ? NULL : &mVertices[0];
+	view.circles = mCircles.empty() ? NULL : &mCircles[0];
+	view.records = mRecords.empty() ? NULL : &mRecords[0];
+	view.vertexCount = (unsigned int)mVertices.size();
+	view.circleCount = (unsigned int)mCircles.size();
+	view.recordCount = (unsigned int)mRecords.size();
+
+	return view;
+}
+
+static bool WriteSection(FILE *file, const void *data, size_t size, unsigned long long offset)
+{
+	static const char padding[16] = { 0 };
+	long long pad = offset - (unsigned long long)ftell(file);
+
+	if (pad > 0 && fwrite(padding, 1, (size_t)pad, file) != (size_t)pad)
+	{
+		return false;
+	}
+
+	return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+bool SceneBuilder::Write(const char *path) const
+{
+	SceneFileHeader header;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	header.vertexCount = (unsigned int)mVertices.size();
+	header.circleCount = (unsigned int)mCircles.size();
+	header.recordCount = (unsigned int)mRecords.size();
+	header.vertexOffset = AlignOffset(sizeof(SceneFileHeader));
+	header.circleOffset = AlignOffset(header.vertexOffset + mVertices.size() * sizeof(Vertex2d));
+	header.recordOffset = AlignOffset(header.circleOffset + mCircles.size() * sizeof(Circle2D));
+
+	FILE *file = NULL;
+
+	if ((file = fopen(path, "wb")) == NULL)
+	{
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	ok = ok && WriteSection(file, mVertices.empty() ? NULL : &mVertices[0], mVertices.size() * sizeof(Vertex2d), header.vertexOffset);
+	ok = ok && WriteSection(file, mCircles.empty() ? NULL : &mCircles[0], mCircles.size() * sizeof(Circle2D), header.circleOffset);
+	ok = ok && WriteSection(file, mRecords.empty() ? NULL : &mRecords[0], mRecords.size() * sizeof(SceneRecord), header.recordOffset);
+
+	fclose(file);
+
+	return ok;
+}
+
+SceneFile::SceneFile()
+{
+	mFile = NULL;
+	mMapping = NULL;
+	mData = NULL;
+	mSize = 0;
+	memset(&mView, 0, sizeof(mView));
+}
+
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+bool SceneFile::Open(const char *path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	mFile = file;
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(SceneFileHeader))
+	{
+		Close();
+		return false;
+	}
+
+	mSize = size.QuadPart;
+	mMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (mMapping == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	mData = (const unsigned char*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SceneFileHeader))
+	{
+		close(fd);
+		return false;
+	}
+
+	mSize = st.st_size;
+
+	void *data = mmap(NULL, (size_t)mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	//the mapping keeps its own reference to the file
+	close(fd);
+
+	mData = data == MAP_FAILED ? NULL : (const unsigned char*)data;
+#endif
+
+	if (mData == NULL || !Validate())
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void SceneFile::Close()
+{
+#ifdef _WIN32
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+
+	if (mMapping)
+	{
+		CloseHandle((HANDLE)mMapping);
+	}
+
+	if (mFile)
+	{
+		CloseHandle((HANDLE)mFile);
+	}
+#else
+	if (mData)
+	{
+		munmap((void*)mData, (size_t)mSize);
+	}
+#endif
+
+	mFile = NULL;
+	mMapping = NULL;
+	mData = NULL;
+	mSize = 0;
+	memset(&mView, 0, sizeof(mView));
+}
+
+bool SceneFile::Validate()
+{
+	const SceneFileHeader *header = (const SceneFileHeader*)mData;
+
+	if (header->magic != SCENE_FILE_MAGIC || header->version != SCENE_FILE_VERSION)
+	{
+		return false;
+	}
+
+	//every section must be aligned and lie entirely inside the file
+	if ((header->vertexOffset | header->circleOffset | header->recordOffset) & 15)
+	{
+		return false;
+	}
+
+	if (!SectionFits(header->vertexOffset, header->vertexCount, sizeof(Vertex2d), mSize) ||
+		!SectionFits(header->circleOffset, header->circleCount, sizeof(Circle2D), mSize) ||
+		!SectionFits(header->recordOffset, header->recordCount, sizeof(SceneRecord), mSize))
+	{
+		return false;
+	}
+
+	mView.vertices = (const Vertex2d*)(mData + header->vertexOffset);
+	mView.circles = (const Circle2D*)(mData + header->circleOffset);
+	mView.records = (const SceneRecord*)(mData + header->recordOffset);
+	mView.vertexCount = header->vertexCount;
+	mView.circleCount = header->circleCount;
+	mView.recordCount = header->recordCount;
+
+	//a NaN or huge value would make the rasterizer step through an effectively endless outline
+	for (unsigned int i = 0; i < mView.vertexCount; i++)
+	{
+		if (!IsFinite(mView.vertices[i].position) || !IsFinite(mView.vertices[i].colour))
+		{
+			return false;
+		}
+	}
+
+	for (unsigned int i = 0; i < mView.circleCount; i++)
+	{
+		const Circle2D &circle = mView.circles[i];
+
+		if (!IsFinite(circle.centre) || !IsFinite(circle.colour) || !(circle.radius >= 0.0f && circle.radius <= SCENE_MAX_CIRCLE_RADIUS))
+		{
+			return false;
+		}
+	}
+
+	//check the record ranges and values once here so DrawSceneView can trust them
+	for (unsigned int i = 0; i < mView.recordCount; i++)
+	{
+		const SceneRecord &record = mView.records[i];
+		unsigned long long end = (unsigned long long)record.first + record.count;
+
+		switch (record.type)
+		{
+		case SCENE_STATE:
+			if (record.first > Rasterizer::POLYGON || record.count > Rasterizer::INTERPOLATED_FILLED || record.param > Rasterizer::ALPHA_BLEND)
+			{
+				return false;
+			}
+			break;
+		case SCENE_LINES:
+		case SCENE_UNFILLED_POLYGON:
+		case SCENE_FILLED_POLYGON:
+		case SCENE_INTERPOLATED_POLYGON:
+			if (end > mView.vertexCount || (record.type != SCENE_LINES && record.count < 3) ||
+				(record.type == SCENE_LINES && record.param > SCENE_MAX_LINE_THICKNESS))
+			{
+				return false;
+			}
+			break;
+		case SCENE_CIRCLES:
+			if (end > mView.circleCount)
+			{
+				return false;
+			}
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool ParseFillMode(const char *name, Rasterizer::FillMode &mode)
+{
+	if (strcmp(name, "unfilled") == 0) { mode = Rasterizer::UNFILLED; }
+	else if (strcmp(name, "solid") == 0) { mode = Rasterizer::SOLID_FILLED; }
+	else if (strcmp(name, "interpolated") == 0) { mode = Rasterizer::INTERPOLATED_FILLED; }
+	else { return false; }
+
+	return true;
+}
+
+bool SceneFile::ConvertTextScene(const char *textPath, const char *binaryPath, char *error, size_t errorSize)
+{
+	FILE *file = NULL;
+
+	if ((file = fopen(textPath, "r")) == NULL)
+	{
+		if (error)
+		{
+			snprintf(error, errorSize, "cannot open %s", textPath);
+		}
+
+		return false;
+	}
+
+	SceneBuilder builder;
+	std::vector<Vertex2d> block;
+	Colour4 colour(1.0f, 1.0f, 1.0f, 1.0f);
+	Rasterizer::FillMode polygonMode = Rasterizer::SOLID_FILLED;
+	int thickness = 1;
+	bool inLines = false;
+	bool inPolygon = false;
+	bool ok = true;
+	char line[512];
+	char a[32], b[32], c[32];
+	int lineNumber = 0;
+
+	while (ok && fgets(line, sizeof(line), file))
+	{
+		lineNumber++;
+
+		char *comment = strchr(line, '#');
+
+		if (comment)
+		{
+			*comment = '\0';
+		}
+
+		char keyword[32];
+
+		if (sscanf(line, "%31s", keyword) != 1)
+		{
+			continue;
+		}
+
+		if (strcmp(keyword, "v") == 0)
+		{
+			Vertex2d vertex;
+			float x, y, r, g, bl, al;
+			int n = sscanf(line, "%*s %f %f %f %f %f %f", &x, &y, &r, &g, &bl, &al);
+
+			if ((!inLines && !inPolygon) || (n != 2 && n != 6))
+			{
+				ok = false;
+				break;
+			}
+
+			vertex.position = Vector2(x, y);
+			vertex.colour = n == 6 ? Colour4(r, g, bl, al) : colour;
+			block.push_back(vertex);
+
+			//the values Validate() rejects are refused here, where the line can be reported
+			ok = IsFinite(vertex.position) && IsFinite(vertex.colour);
+		}
+		else if (strcmp(keyword, "end") == 0)
+		{
+			if (inLines && !block.empty())
+			{
+				builder.AddLines(&block[0], (int)block.size(), thickness);
+			}
+			else if (inPolygon && block.size() >= 3)
+			{
+				if (polygonMode == Rasterizer::UNFILLED)
+					builder.AddUnfilledPolygon(&block[0], (int)block.size());
+				else if (polygonMode == Rasterizer::SOLID_FILLED)
+					builder.AddFilledPolygon(&block[0], (int)block.size());
+				else
+					builder.AddInterpolatedPolygon(&block[0], (int)block.size());
+			}
+			else
+			{
+				ok = false;
+			}
+
+			block.clear();
+			inLines = inPolygon = false;
+		}
+		else if (inLines || inPolygon)
+		{
+			//only vertices may appear inside a block
+			ok = false;
+		}
+		else if (strcmp(keyword, "colour") == 0)
+		{
+			float r, g, bl, al;
+			ok = sscanf(line, "%*s %f %f %f %f", &r, &g, &bl, &al) == 4;
+			colour = Colour4(r, g, bl, al);
+			ok = ok && IsFinite(colour);
+		}
+		else if (strcmp(keyword, "state") == 0)
+		{
+			Rasterizer::FillMode fill;
+
+			ok = sscanf(line, "%*s %31s %31s %31s", a, b, c) == 3 && ParseFillMode(b, fill);
+
+			if (ok)
+			{
+				builder.AddState(strcmp(a, "line") == 0 ? Rasterizer::LINE : Rasterizer::POLYGON, fill,
+					strcmp(c, "alpha") == 0 ? Rasterizer::ALPHA_BLEND : Rasterizer::NO_BLEND);
+			}
+		}
+		else if (strcmp(keyword, "lines") == 0)
+		{
+			inLines = sscanf(line, "%*s %d", &thickness) == 1 && thickness >= 0 && thickness <= (int)SCENE_MAX_LINE_THICKNESS;
+			ok = inLines;
+		}
+		else if (strcmp(keyword, "polygon") == 0)
+		{
+			inPolygon = sscanf(line, "%*s %31s", a) == 1 && ParseFillMode(a, polygonMode);
+			ok = inPolygon;
+		}
+		else if (strcmp(keyword, "circle") == 0)
+		{
+			Circle2D circle;
+			float x, y, radius;
+
+			ok = sscanf(line, "%*s %f %f %f %31s", &x, &y, &radius, a) == 4;
+
+			circle.colour = colour;
+			circle.centre = Vector2(x, y);
+			circle.radius = radius;
+			ok = ok && IsFinite(circle.centre) && IsFinite(circle.colour) && radius >= 0.0f && radius <= SCENE_MAX_CIRCLE_RADIUS;
+
+			if (ok)
+			{
+				builder.AddCircles(&circle, 1, strcmp(a, "filled") == 0);
+			}
+		}
+		else
+		{
+			ok = false;
+		}
+	}
+
+	fclose(file);
+
+	if (!ok || inLines || inPolygon)
+	{
+		if (error)
+		{
+			line[strcspn(line, "\r\n")] = '\0';
+			snprintf(error, errorSize, "%s:%d: cannot parse %s", textPath, lineNumber, ok ? "unterminated block" : line);
+		}
+
+		return false;
+	}
+
+	if (!builder.Write(binaryPath))
+	{
+		if (error)
+		{
+			snprintf(error, errorSize, "cannot write %s", binaryPath);
+		}
+
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vector>
+#include "TinyRasterTypes.h"
+#include "Rasterizer.h"
+
+//Binary scene format (*.tscn)
+//A scene file is laid out as follows, every section starts on a 16 byte boundary:
+//	SceneFileHeader
+//	Vertex2d		vertices[vertexCount]	--- shared vertex pool referenced by primitive records
+//	Circle2D		circles[circleCount]	--- circle pool referenced by circle records
+//	SceneRecord		records[recordCount]	--- primitives and state blocks in submission order
+//The pools are stored in the in-memory layout of Vertex2d and Circle2D,
+//so a mapped file can be handed to the rasterizer without parsing or copying.
+
+const unsigned int SCENE_FILE_MAGIC = 0x4E435354;		//'TSCN'
+const unsigned int SCENE_FILE_VERSION = 2;
+const unsigned int SCENE_MAX_LINE_THICKNESS = 256;		//thickest line a scene may hold, in pixels
+const float SCENE_MAX_CIRCLE_RADIUS = 4096.0f;			//largest circle radius a scene may hold, in pixels
+
+//enum for the type of a scene record
+enum SceneRecordType {
+	SCENE_STATE = 0,				//state block: first = GeometryMode, count = FillMode, param = BlendMode
+	SCENE_LINES,					//pairs of vertices drawn with DrawLine2D, param = thickness
+	SCENE_UNFILLED_POLYGON,			//polygon drawn with DrawUnfilledPolygon2D
+	SCENE_FILLED_POLYGON,			//polygon drawn with ScanlineFillPolygon2D
+	SCENE_INTERPOLATED_POLYGON,		//polygon drawn with ScanlineInterpolatedFillPolygon2D
+	SCENE_CIRCLES					//circles drawn with DrawCircle2D, param = filled
+};
+
+//Header at the start of a scene file
+typedef struct _SceneFileHeader
+{
+	unsigned int magic;					//must be SCENE_FILE_MAGIC
+	unsigned int version;				//must be SCENE_FILE_VERSION
+	unsigned int vertexCount;			//number of entries in the vertex pool
+	unsigned int circleCount;			//number of entries in the circle pool
+	unsigned int recordCount;			//number of primitive and state records
+	unsigned int reserved;				//padding, always 0
+	unsigned long long vertexOffset;	//byte offset of the vertex pool from the start of the file
+	unsigned long long circleOffset;	//byte offset of the circle pool from the start of the file
+	unsigned long long recordOffset;	//byte offset of the records from the start of the file
+} SceneFileHeader;
+
+//A single primitive or state record
+typedef struct _SceneRecord
+{
+	unsigned int type;				//a SceneRecordType
+	unsigned int first;				//index of the first vertex/circle in its pool
+	unsigned int count;				//number of vertices/circles used by the record
+	unsigned int param;				//record specific parameter, see SceneRecordType
+} SceneRecord;
+
+//Read-only view of a scene, either backed by a mapped file or by a SceneBuilder
+typedef struct _SceneView
+{
+	const Vertex2d *vertices;
+	const Circle2D *circles;
+	const SceneRecord *records;
+	unsigned int vertexCount;
+	unsigned int circleCount;
+	unsigned int recordCount;
+} SceneView;
+
+//Submit every record of a scene to the rasterizer in order
+//input:	Rasterizer *rasterizer --- the rasterizer to draw with
+//			const SceneView &scene --- the scene to be drawn
+void DrawSceneView(Rasterizer *rasterizer, const SceneView &scene);
+
+//This class accumulates a scene in memory and writes it out in the binary format
+class SceneBuilder
+{
+private:
+	std::vector<Vertex2d>		mVertices;
+	std::vector<Circle2D>		mCircles;
+	std::vector<SceneRecord>	mRecords;
+
+	void AddRecord(SceneRecordType type, unsigned int first, unsigned int count, unsigned int param);
+
+public:
+	void Clear();
+
+	void AddState(Rasterizer::GeometryMode geometry, Rasterizer::FillMode fill, Rasterizer::BlendMode blend);
+	void AddLines(const Vertex2d *vertices, int count, int thickness = 1);
+	void AddUnfilledPolygon(const Vertex2d *vertices, int count);
+	void AddFilledPolygon(const Vertex2d *vertices, int count);
+	void AddInterpolatedPolygon(const Vertex2d *vertices, int count);
+	void AddCircles(const Circle2D *circles, int count, bool filled);
+
+	//Get a view of the scene built so far, invalidated by any further Add call
+	SceneView GetView() const;
+
+	//Write the scene to a binary scene file
+	//input:	const char *path --- destination file
+	//output:	true if the file was written successfully
+	bool Write(const char *path) const;
+};
+
+//This class maps a binary scene file into memory
+class SceneFile
+{
+private:
+	void				*mFile;			//platform file handle
+	void				*mMapping;		//platform mapping handle
+	const unsigned char	*mData;			//start of the mapped file
+	unsigned long long	mSize;			//size of the mapped file in bytes
+	SceneView			mView;
+
+	bool Validate();
+
+public:
+	SceneFile();
+	~SceneFile();
+
+	//Map a scene file, any previously opened file is closed first
+	//input:	const char *path --- path of a binary scene file
+	//output:	true if the file was mapped and passed validation
+	bool Open(const char *path);
+	void Close();
+
+	inline bool IsOpen() const { return mData != NULL; }
+	inline const SceneView &GetView() const { return mView; }
+
+	//Convert a scene from the text format into the binary format
+	//The text format is line based, '#' starts a comment:
+	//	colour r g b a						--- current colour used by vertices and circles without a colour
+	//	state <line|polygon> <unfilled|solid|interpolated> <none|alpha>
+	//	lines <thickness>					--- followed by vertex lines, closed by 'end'
+	//	polygon <unfilled|solid|interpolated>	--- followed by vertex lines, closed by 'end'
+	//	v x y [r g b a]						--- a vertex of the current lines/polygon block
+	//	circle x y radius <filled|unfilled>
+	//input:	const char *textPath --- source text scene
+	//			const char *binaryPath --- destination binary scene
+	//output:	true if the conversion succeeded, otherwise error receives a description of the failure
+	//			if it is not NULL, e.g. the line that could not be parsed
+	static bool ConvertTextScene(const char *textPath, const char *binaryPath, char *error = NULL, size_t errorSize = 0);
+};
@@ -0,0 +1,239 @@
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "SceneGenerator.h"
+
+namespace SceneGenerator
+{
+	//Small xorshift generator so scenes are identical on every platform and standard library
+	class Random
+	{
+	private:
+		unsigned int mState;
+
+	public:
+		Random(unsigned int seed)
+		{
+			mState = seed ? seed : 0x9E3779B9;
+		}
+
+		inline unsigned int Next()
+		{
+			mState ^= mState << 13;
+			mState ^= mState >> 17;
+			mState ^= mState << 5;
+			return mState;
+		}
+
+		//uniform float in [0, 1)
+		inline float NextFloat()
+		{
+			return (Next() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		//uniform float in [lo, hi)
+		inline float Range(float lo, float hi)
+		{
+			return lo + (hi - lo) * NextFloat();
+		}
+
+		//uniform int in [lo, hi]
+		inline int RangeInt(int lo, int hi)
+		{
+			return lo + (int)(Next() % (unsigned int)(hi - lo + 1));
+		}
+	};
+
+	static const float PI = 3.14159265f;
+
+	static Colour4 RandomColour(Random &random, float alpha)
+	{
+		return Colour4(random.NextFloat(), random.NextFloat(), random.NextFloat(), alpha);
+	}
+
+	//Pick the centre of a primitive, clustered around anchors when polygons overlap
+	static Vector2 RandomCentre(Random &random, const StressSceneParams &params, const std::vector<Vector2> &anchors, float size)
+	{
+		if (anchors.empty())
+		{
+			return Vector2(random.Range(0.0f, (float)params.width), random.Range(0.0f, (float)params.height));
+		}
+
+		const Vector2 &anchor = anchors[random.Next() % anchors.size()];
+		float jitter = size * 0.1f;
+
+		return Vector2(anchor[0] + random.Range(-jitter, jitter), anchor[1] + random.Range(-jitter, jitter));
+	}
+
+	//Convex polygon with 3 to 8 vertices on an ellipse, ordered counter-clockwise
+	static void ConvexPolygon(Random &random, const Vector2 &centre, float size, const Colour4 &colour, bool gradient, std::vector<Vertex2d> &out)
+	{
+		float angles[8];
+		int count = random.RangeInt(3, 8);
+		float rx = size * 0.5f;
+		float ry = size * random.Range(0.25f, 0.5f);
+
+		for (int i = 0; i < count; i++)
+		{
+			angles[i] = random.Range(0.0f, 2.0f * PI);
+		}
+
+		std::sort(angles, angles + count);
+
+		out.clear();
+
+		for (int i = 0; i < count; i++)
+		{
+			Vertex2d v;
+			v.colour = gradient ? RandomColour(random, colour[3]) : colour;
+			v.position = Vector2(centre[0] + rx * cosf(angles[i]), centre[1] + ry * sinf(angles[i]));
+			out.push_back(v);
+		}
+	}
+
+	//Concave comb-shaped polygon similar to AssignmentTests::comb, ordered counter-clockwise
+	static void CombPolygon(Random &random, const Vector2 &centre, float size, int teeth, const Colour4 &colour, bool gradient, std::vector<Vertex2d> &out)
+	{
+		float left = centre[0] - size * 0.5f;
+		float bottom = centre[1] - size * 0.5f;
+		float spine = size * random.Range(0.2f, 0.4f);
+		float step = size / (2 * teeth);
+
+		out.clear();
+
+		Vertex2d v;
+		v.colour = colour;
+
+		v.position = Vector2(left, bottom);
+		out.push_back(v);
+		v.position = Vector2(left + size, bottom);
+		out.push_back(v);
+
+		//walk the teeth from right to left along the top edge
+		for (int i = 2 * teeth; i > 0; i--)
+		{
+			float height = (i & 1) ? spine : size * random.Range(0.6f, 1.0f);
+			v.position = Vector2(left + i * step, bottom + height);
+			out.push_back(v);
+		}
+
+		v.position = Vector2(left, bottom + spine);
+		out.push_back(v);
+
+		if (gradient)
+		{
+			for (size_t i = 0; i < out.size(); i++)
+			{
+				out[i].colour = RandomColour(random, colour[3]);
+			}
+		}
+	}
+
+	StressSceneParams DefaultParams(int primitiveCount, float size, int width, int height, unsigned int seed)
+	{
+		StressSceneParams params;
+
+		params.seed = seed;
+		params.width = width;
+		params.height = height;
+		params.lineCount = primitiveCount / 5;
+		params.maxLineThickness = 3;
+		params.convexPolygonCount = primitiveCount * 3 / 10;
+		params.concavePolygonCount = primitiveCount / 5;
+		params.combTeeth = 5;
+		params.circleCount = primitiveCount - params.lineCount - params.convexPolygonCount - params.concavePolygonCount;
+		params.minSize = size;
+		params.maxSize = size;
+		params.gradientFraction = 0.25f;
+		params.overlapDepth = 0;
+
+		return params;
+	}
+
+	void Generate(const StressSceneParams &params, SceneBuilder &builder)
+	{
+		Random random(params.seed);
+		std::vector<Vector2> anchors;
+		std::vector<Vertex2d> polygon;
+		Rasterizer::BlendMode blend = params.overlapDepth > 0 ? Rasterizer::ALPHA_BLEND : Rasterizer::NO_BLEND;
+		float alpha = params.overlapDepth > 0 ? 0.5f : 1.0f;
+		int polygonCount = params.convexPolygonCount + params.concavePolygonCount;
+
+		builder.Clear();
+
+		if (params.overlapDepth > 0)
+		{
+			int anchorCount = std::max(1, polygonCount / params.overlapDepth);
+
+			for (int i = 0; i < anchorCount; i++)
+			{
+				anchors.push_back(Vector2(random.Range(0.0f, (float)params.width), random.Range(0.0f, (float)params.height)));
+			}
+		}
+
+		//lines
+		builder.AddState(Rasterizer::LINE, Rasterizer::SOLID_FILLED, Rasterizer::NO_BLEND);
+
+		for (int i = 0; i < params.lineCount; i++)
+		{
+			Vertex2d line[2];
+			float size = random.Range(params.minSize, params.maxSize);
+			float angle = random.Range(0.0f, 2.0f * PI);
+			Vector2 centre = RandomCentre(random, params, std::vector<Vector2>(), size);
+
+			line[0].colour = line[1].colour = RandomColour(random, 1.0f);
+			line[0].position = Vector2(centre[0] - 0.5f * size * cosf(angle), centre[1] - 0.5f * size * sinf(angle));
+			line[1].position = Vector2(centre[0] + 0.5f * size * cosf(angle), centre[1] + 0.5f * size * sinf(angle));
+
+			builder.AddLines(line, 2, random.RangeInt(1, std::max(1, params.maxLineThickness)));
+		}
+
+		//polygons, solid ones first then the gradient filled ones so each group needs one state block
+		int gradientConvex = (int)(params.convexPolygonCount * params.gradientFraction + 0.5f);
+		int gradientConcave = (int)(params.concavePolygonCount * params.gradientFraction + 0.5f);
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			bool gradient = pass == 1;
+			int convex = gradient ? gradientConvex : params.convexPolygonCount - gradientConvex;
+			int concave = gradient ? gradientConcave : params.concavePolygonCount - gradientConcave;
+
+			builder.AddState(Rasterizer::POLYGON, gradient ? Rasterizer::INTERPOLATED_FILLED : Rasterizer::SOLID_FILLED, blend);
+
+			for (int i = 0; i < convex + concave; i++)
+			{
+				float size = random.Range(params.minSize, params.maxSize);
+				Vector2 centre = RandomCentre(random, params, anchors, size);
+				Colour4 colour = RandomColour(random, alpha);
+
+				if (i < convex)
+					ConvexPolygon(random, centre, size, colour, gradient, polygon);
+				else
+					CombPolygon(random, centre, size, std::max(1, params.combTeeth), colour, gradient, polygon);
+
+				if (gradient)
+					builder.AddInterpolatedPolygon(&polygon[0], (int)polygon.size());
+				else
+					builder.AddFilledPolygon(&polygon[0], (int)polygon.size());
+			}
+		}
+
+		//circles
+		builder.AddState(Rasterizer::POLYGON, Rasterizer::SOLID_FILLED, blend);
+
+		for (int i = 0; i < params.circleCount; i++)
+		{
+			Circle2D circle;
+			float size = random.Range(params.minSize, params.maxSize);
+
+			circle.centre = RandomCentre(random, params, anchors, size);
+			circle.radius = 0.5f * size;
+			circle.colour = RandomColour(random, alpha);
+
+			builder.AddCircles(&circle, 1, (i & 1) == 0);
+		}
+
+		builder.AddState(Rasterizer::LINE, Rasterizer::SOLID_FILLED, Rasterizer::NO_BLEND);
+	}
+}
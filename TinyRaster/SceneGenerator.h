@@ -0,0 +1,38 @@
+#pragma once
+
+#include "SceneFile.h"
+
+//Parameters of a synthetic stress scene
+//Primitive sizes are the extent of a primitive's bounding box in pixels
+typedef struct _StressSceneParams
+{
+	unsigned int seed;				//seed of the random generator, equal seeds give equal scenes
+	int width;						//width of the area primitives are placed in
+	int height;						//height of the area primitives are placed in
+	int lineCount;					//number of lines
+	int maxLineThickness;			//lines get a thickness in [1, maxLineThickness]
+	int convexPolygonCount;			//number of convex polygons
+	int concavePolygonCount;		//number of concave comb-shaped polygons
+	int combTeeth;					//number of teeth of a concave polygon
+	int circleCount;				//number of circles, alternating filled and unfilled
+	float minSize;					//smallest primitive size
+	float maxSize;					//largest primitive size
+	float gradientFraction;			//fraction of the polygons drawn with an interpolated fill
+	int overlapDepth;				//0 for opaque polygons, otherwise polygons are translucent and stacked
+									//around shared anchors so each anchor is covered about overlapDepth times
+} StressSceneParams;
+
+namespace SceneGenerator
+{
+	//Fill params with a balanced scene of roughly primitiveCount primitives
+	//input:	int primitiveCount --- total number of primitives
+	//			float size --- size of every primitive in pixels
+	//			int width, int height --- area the primitives are placed in
+	//			unsigned int seed --- seed of the random generator
+	StressSceneParams DefaultParams(int primitiveCount, float size, int width, int height, unsigned int seed = 1);
+
+	//Generate a scene deterministically from params
+	//input:	const StressSceneParams &params --- description of the scene
+	//output:	SceneBuilder &builder --- receives the scene, previous content is discarded
+	void Generate(const StressSceneParams &params, SceneBuilder &builder);
+}
@@ -0,0 +1,492 @@
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+#include "SceneGraph.h"
+#include "TraceEvents.h"
+
+const float SceneGraph::FULL_REDRAW_FRACTION = 0.5f;
+
+//Pixels added around a primitive's vertices to cover line thickness, anti-aliased edges and coordinate truncation
+static const int BOUNDS_PADDING = 2;
+
+static inline bool IsEmptyRect(const ClipRect &rect)
+{
+	return rect.left >= rect.right || rect.bottom >= rect.top;
+}
+
+static inline bool RectsOverlap(const ClipRect &a, const ClipRect &b)
+{
+	return a.left < b.right && b.left < a.right && a.bottom < b.top && b.bottom < a.top;
+}
+
+SceneGraph::SceneGraph()
+{
+	mBackground = Colour4(0.0f, 0.0f, 0.0f, 1.0f);
+	mFullRedraw = true;
+}
+
+void SceneGraph::Clear()
+{
+	mNodes.clear();
+	mDamage.clear();
+	mGrid.Reset(0, 0);
+	mFullRedraw = true;
+}
+
+void SceneGraph::SetBackground(const Colour4 &colour)
+{
+	mBackground = colour;
+	mFullRedraw = true;
+}
+
+int SceneGraph::AddNode(int parent, SceneRecordType type, int param)
+{
+	SceneNode node;
+
+	node.parent = parent;
+	node.type = type;
+	node.param = param;
+	node.tint = Colour4(1.0f, 1.0f, 1.0f, 1.0f);
+	node.blendMode = Rasterizer::NO_BLEND;
+	node.fillMode = Rasterizer::SOLID_FILLED;
+	node.visible = true;
+	node.dirty = true;
+	node.shown = false;
+	node.bounds.left = node.bounds.right = 0;
+	node.bounds.bottom = node.bounds.top = 0;
+
+	mNodes.push_back(node);
+
+	return (int)mNodes.size() - 1;
+}
+
+int SceneGraph::AddGroup(int parent)
+{
+	return AddNode(parent, SCENE_STATE, 0);
+}
+
+int SceneGraph::AddLines(int parent, const Vertex2d *vertices, int count, int thickness)
+{
+	int node = AddNode(parent, SCENE_LINES, thickness);
+
+	mNodes[node].vertices.assign(vertices, vertices + count);
+
+	return node;
+}
+
+int SceneGraph::AddUnfilledPolygon(int parent, const Vertex2d *vertices, int count)
+{
+	int node = AddNode(parent, SCENE_UNFILLED_POLYGON, 0);
+
+	mNodes[node].vertices.assign(vertices, vertices + count);
+
+	return node;
+}
+
+int SceneGraph::AddFilledPolygon(int parent, const Vertex2d *vertices, int count)
+{
+	int node = AddNode(parent, SCENE_FILLED_POLYGON, 0);
+
+	mNodes[node].vertices.assign(vertices, vertices + count);
+
+	return node;
+}
+
+int SceneGraph::AddInterpolatedPolygon(int parent, const Vertex2d *vertices, int count)
+{
+	int node = AddNode(parent, SCENE_INTERPOLATED_POLYGON, 0);
+
+	mNodes[node].vertices.assign(vertices, vertices + count);
+	mNodes[node].fillMode = Rasterizer::INTERPOLATED_FILLED;
+
+	return node;
+}
+
+int SceneGraph::AddCircles(int parent, const Circle2D *circles, int count, bool filled)
+{
+	int node = AddNode(parent, SCENE_CIRCLES, filled ? 1 : 0);
+
+	mNodes[node].circles.assign(circles, circles + count);
+
+	return node;
+}
+
+void SceneGraph::AddSceneView(int parent, const SceneView &scene)
+{
+	Rasterizer::FillMode fillMode = Rasterizer::SOLID_FILLED;
+	Rasterizer::BlendMode blendMode = Rasterizer::NO_BLEND;
+
+	for (unsigned int i = 0; i < scene.recordCount; i++)
+	{
+		const SceneRecord &record = scene.records[i];
+
+		if (record.type == SCENE_STATE)
+		{
+			fillMode = (Rasterizer::FillMode)record.count;
+			blendMode = (Rasterizer::BlendMode)record.param;
+			continue;
+		}
+
+		//lines and circles get a node each, so their bounds stay tight
+		int step = record.type == SCENE_LINES ? 2 : record.type == SCENE_CIRCLES ? 1 : record.count;
+
+		for (unsigned int first = record.first; first + step <= record.first + record.count && step > 0; first += step)
+		{
+			int node = AddNode(parent, (SceneRecordType)record.type, record.param);
+
+			if (record.type == SCENE_CIRCLES)
+			{
+				mNodes[node].circles.assign(scene.circles + first, scene.circles + first + step);
+			}
+			else
+			{
+				mNodes[node].vertices.assign(scene.vertices + first, scene.vertices + first + step);
+			}
+
+			mNodes[node].fillMode = fillMode;
+			mNodes[node].blendMode = blendMode;
+		}
+	}
+}
+
+void SceneGraph::SetTransform(int node, const Transform2D &transform)
+{
+	mNodes[node].transform = transform;
+	Touch(node);
+}
+
+void SceneGraph::SetTint(int node, const Colour4 &tint)
+{
+	mNodes[node].tint = tint;
+	Touch(node);
+}
+
+void SceneGraph::SetVisible(int node, bool visible)
+{
+	mNodes[node].visible = visible;
+	Touch(node);
+}
+
+void SceneGraph::SetBlendMode(int node, Rasterizer::BlendMode mode)
+{
+	mNodes[node].blendMode = mode;
+	Touch(node);
+}
+
+void SceneGraph::SetFillMode(int node, Rasterizer::FillMode mode)
+{
+	mNodes[node].fillMode = mode;
+	Touch(node);
+}
+
+void SceneGraph::SetVertices(int node, const Vertex2d *vertices, int count)
+{
+	mNodes[node].vertices.assign(vertices, vertices + count);
+	Touch(node);
+}
+
+void SceneGraph::SetCircles(int node, const Circle2D *circles, int count)
+{
+	mNodes[node].circles.assign(circles, circles + count);
+	Touch(node);
+}
+
+void SceneGraph::TransformNode(SceneNode &node)
+{
+	float minX = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float minY = FLT_MAX;
+	float maxY = -FLT_MAX;
+
+	node.worldVertices.resize(node.vertices.size());
+	node.worldCircles.resize(node.circles.size());
+
+	if (!node.vertices.empty())
+	{
+		node.world.Apply(&node.vertices[0], &node.worldVertices[0], (int)node.vertices.size());
+	}
+
+	for (size_t i = 0; i < node.vertices.size(); i++)
+	{
+		Vertex2d &vertex = node.worldVertices[i];
+
+		vertex.colour = vertex.colour * node.tint;
+
+		minX = std::min(minX, vertex.position[0]);
+		maxX = std::max(maxX, vertex.position[0]);
+		minY = std::min(minY, vertex.position[1]);
+		maxY = std::max(maxY, vertex.position[1]);
+	}
+
+	for (size_t i = 0; i < node.circles.size(); i++)
+	{
+		Circle2D &circle = node.worldCircles[i];
+
+		circle = node.circles[i];
+		circle.centre = node.world.Apply(circle.centre);
+		circle.radius *= node.world.ScaleFactor();
+		circle.colour = circle.colour * node.tint;
+
+		minX = std::min(minX, circle.centre[0] - circle.radius);
+		maxX = std::max(maxX, circle.centre[0] + circle.radius);
+		minY = std::min(minY, circle.centre[1] - circle.radius);
+		maxY = std::max(maxY, circle.centre[1] + circle.radius);
+	}
+
+	if (minX > maxX)
+	{
+		node.bounds.left = node.bounds.right = 0;
+		node.bounds.bottom = node.bounds.top = 0;
+		return;
+	}
+
+	//thick lines extend half their thickness to either side
+	int padding = BOUNDS_PADDING + (node.type == SCENE_LINES ? node.param / 2 : 0);
+
+	node.bounds.left = (int)floorf(minX) - padding;
+	node.bounds.right = (int)ceilf(maxX) + padding + 1;
+	node.bounds.bottom = (int)floorf(minY) - padding;
+	node.bounds.top = (int)ceilf(maxY) + padding + 1;
+}
+
+void SceneGraph::AddDamage(const ClipRect &rect)
+{
+	//damage off-screen is dropped here, so moving a large scene does not merge the rectangles of hidden nodes
+	ClipRect clipped;
+
+	clipped.left = std::max(rect.left, 0);
+	clipped.right = std::min(rect.right, mGrid.GetWidth());
+	clipped.bottom = std::max(rect.bottom, 0);
+	clipped.top = std::min(rect.top, mGrid.GetHeight());
+
+	if (!IsEmptyRect(clipped))
+	{
+		mDamage.push_back(clipped);
+	}
+}
+
+void SceneGraph::MergeDamage()
+{
+	//replace overlapping rectangles by their bounds until every pair is disjoint; every pass lets each rectangle
+	//absorb all later ones it overlaps, another pass is only needed when a grown rectangle reaches an earlier one
+	bool merged = true;
+
+	while (merged)
+	{
+		merged = false;
+
+		for (size_t i = 0; i < mDamage.size(); i++)
+		{
+			for (size_t j = i + 1; j < mDamage.size(); )
+			{
+				if (!RectsOverlap(mDamage[i], mDamage[j]))
+				{
+					j++;
+					continue;
+				}
+
+				mDamage[i].left = std::min(mDamage[i].left, mDamage[j].left);
+				mDamage[i].right = std::max(mDamage[i].right, mDamage[j].right);
+				mDamage[i].bottom = std::min(mDamage[i].bottom, mDamage[j].bottom);
+				mDamage[i].top = std::max(mDamage[i].top, mDamage[j].top);
+
+				//the order of the rectangles does not matter, the last one takes the place of the absorbed one
+				mDamage[j] = mDamage.back();
+				mDamage.pop_back();
+				merged = true;
+
+				//the grown rectangle may now overlap a later one it was already compared with
+				j = i + 1;
+			}
+		}
+	}
+}
+
+long long SceneGraph::DamageArea() const
+{
+	long long area = 0;
+
+	for (size_t i = 0; i < mDamage.size(); i++)
+	{
+		area += (long long)(mDamage[i].right - mDamage[i].left) * (mDamage[i].top - mDamage[i].bottom);
+	}
+
+	return area;
+}
+
+void SceneGraph::DrawNode(Rasterizer *rasterizer, const SceneNode &node)
+{
+	const Vertex2d *vertices = node.worldVertices.empty() ? NULL : &node.worldVertices[0];
+	int count = (int)node.worldVertices.size();
+
+	rasterizer->SetBlendMode(node.blendMode);
+	rasterizer->SetFillMode(node.fillMode);
+
+	switch (node.type)
+	{
+	case SCENE_LINES:
+		rasterizer->SetGeometryMode(Rasterizer::LINE);
+
+		for (int v = 0; v + 1 < count; v += 2)
+		{
+			rasterizer->DrawLine2D(vertices[v], vertices[v + 1], node.param);
+		}
+		break;
+	case SCENE_UNFILLED_POLYGON:
+	case SCENE_FILLED_POLYGON:
+	case SCENE_INTERPOLATED_POLYGON:
+		if (count < 3)
+		{
+			break;
+		}
+
+		rasterizer->SetGeometryMode(Rasterizer::POLYGON);
+
+		if (node.type == SCENE_UNFILLED_POLYGON)
+		{
+			rasterizer->DrawUnfilledPolygon2D(vertices, count);
+		}
+		else if (node.type == SCENE_FILLED_POLYGON)
+		{
+			rasterizer->ScanlineFillPolygon2D(vertices, count);
+		}
+		else
+		{
+			rasterizer->ScanlineInterpolatedFillPolygon2D(vertices, count);
+		}
+		break;
+	case SCENE_CIRCLES:
+		for (size_t c = 0; c < node.worldCircles.size(); c++)
+		{
+			//unfilled circles are drawn in the foreground colour, which would otherwise depend on the nodes drawn before
+			rasterizer->SetFGColour(node.worldCircles[c].colour);
+			rasterizer->DrawCircle2D(node.worldCircles[c], node.param != 0);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void SceneGraph::Update(Rasterizer *rasterizer)
+{
+	TRACE_SCOPE_ARG("SceneUpdate", "nodes", (int)mNodes.size());
+
+	int width = rasterizer->Width();
+	int height = rasterizer->Height();
+
+	mDamage.clear();
+
+	//index the shown nodes again when the framebuffer changes
+	if (mGrid.GetWidth() != width || mGrid.GetHeight() != height)
+	{
+		mGrid.Reset(width, height);
+
+		for (size_t i = 0; i < mNodes.size(); i++)
+		{
+			if (mNodes[i].shown)
+			{
+				mGrid.Insert((int)i, mNodes[i].bounds);
+			}
+		}
+	}
+
+	//parents come first, so a child sees its parent's new world transform and visibility
+	for (size_t i = 0; i < mNodes.size(); i++)
+	{
+		SceneNode &node = mNodes[i];
+		const SceneNode *parent = node.parent >= 0 ? &mNodes[node.parent] : NULL;
+
+		if (parent && parent->dirty)
+		{
+			node.dirty = true;
+		}
+
+		if (!node.dirty)
+		{
+			continue;
+		}
+
+		if (node.shown)
+		{
+			AddDamage(node.bounds);
+			mGrid.Remove((int)i, node.bounds);
+		}
+
+		node.world = parent ? parent->world * node.transform : node.transform;
+		node.shown = node.visible && (!parent || parent->shown);
+		TransformNode(node);
+
+		if (node.shown)
+		{
+			AddDamage(node.bounds);
+			mGrid.Insert((int)i, node.bounds);
+		}
+	}
+
+	for (size_t i = 0; i < mNodes.size(); i++)
+	{
+		mNodes[i].dirty = false;
+	}
+
+	//the raw rectangles overlap, so their summed area is an upper bound of the damage: a large update, e.g. a pan
+	//that moves every visible node, falls back to a full redraw before any time is spent merging
+	double fullRedrawArea = FULL_REDRAW_FRACTION * width * height;
+	bool fullRedraw = mFullRedraw || DamageArea() > fullRedrawArea;
+
+	if (!fullRedraw)
+	{
+		MergeDamage();
+
+		//merged bounds can cover more pixels than the rectangles they replace
+		fullRedraw = DamageArea() > fullRedrawArea;
+	}
+
+	if (fullRedraw)
+	{
+		ClipRect full = { 0, width, height, 0 };
+
+		rasterizer->Clear(mBackground);
+		mGrid.Query(full, mVisible);
+
+		for (size_t i = 0; i < mVisible.size(); i++)
+		{
+			DrawNode(rasterizer, mNodes[mVisible[i]]);
+		}
+
+		mDamage.assign(1, full);
+		mFullRedraw = false;
+	}
+	else
+	{
+		ClipRect clip = rasterizer->GetClipRectangle();
+
+		//the rectangles are disjoint, so each pixel is cleared and redrawn exactly once
+		for (size_t r = 0; r < mDamage.size(); r++)
+		{
+			const ClipRect &rect = mDamage[r];
+
+			rasterizer->SetClipRectangle(rect.left, rect.right, rect.bottom, rect.top);
+			rasterizer->SetBlendMode(Rasterizer::NO_BLEND);
+			rasterizer->FillRect(rect.left, rect.bottom, rect.right - rect.left, rect.top - rect.bottom, mBackground);
+
+			mGrid.Query(rect, mVisible);
+
+			for (size_t i = 0; i < mVisible.size(); i++)
+			{
+				const SceneNode &node = mNodes[mVisible[i]];
+
+				if (RectsOverlap(node.bounds, rect))
+				{
+					DrawNode(rasterizer, node);
+				}
+			}
+		}
+
+		rasterizer->SetClipRectangle(clip.left, clip.right, clip.bottom, clip.top);
+	}
+
+	rasterizer->SetBlendMode(Rasterizer::NO_BLEND);
+	rasterizer->SetFillMode(Rasterizer::SOLID_FILLED);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include "TinyRasterTypes.h"
+#include "Rasterizer.h"
+#include "SceneFile.h"
+#include "Transform2D.h"
+#include "SpatialGrid.h"
+
+//A node of a retained scene, holding at most one primitive
+typedef struct _SceneNode
+{
+	int parent;							//index of the parent node, -1 for a top-level node
+	SceneRecordType type;				//primitive of the node, SCENE_STATE for a group that only carries a transform
+	std::vector<Vertex2d> vertices;		//vertices of the lines or polygon in the node's space
+	std::vector<Circle2D> circles;		//circles in the node's space
+	int param;							//line thickness for SCENE_LINES, non-zero for filled SCENE_CIRCLES
+	Transform2D transform;				//transform from the node's space to its parent's
+	Colour4 tint;						//multiplied with the colours of the primitive
+	Rasterizer::BlendMode blendMode;	//blend mode the primitive is drawn with
+	Rasterizer::FillMode fillMode;		//INTERPOLATED_FILLED interpolates the colours along lines
+	bool visible;						//false hides the node and its children
+	bool dirty;							//changed since the last update
+
+	Transform2D world;					//transform from the node's space to the framebuffer at the last update
+	bool shown;							//visible at the last update, its parents included
+	ClipRect bounds;					//pixels the primitive may have touched at the last update
+	std::vector<Vertex2d> worldVertices;	//vertices at the last update, transformed and tinted
+	std::vector<Circle2D> worldCircles;	//circles at the last update, transformed and tinted
+} SceneNode;
+
+//This class keeps a retained scene of primitives and redraws only what changes.
+//Nodes form a tree; a node's transform is relative to its parent and hiding a node hides its children.
+//Every change marks the node dirty, and Update() damages the pixels the node covered before the change
+//and the pixels it covers after it. The damage is merged into disjoint rectangles, each of which is cleared
+//to the background and redrawn with every node that intersects it, clipped to the rectangle, in node order.
+//Pixels outside the damage keep their content from the previous update, so the framebuffer must not be
+//drawn to between updates except for overlays that are redrawn inside GetDamage().
+//Shown nodes are indexed by a uniform grid over the framebuffer, so redrawing a rectangle only visits the nodes
+//near it and nodes lying entirely off-screen, e.g. the far parts of a large map, are never visited.
+class SceneGraph
+{
+private:
+	std::vector<SceneNode> mNodes;		//nodes in drawing order, parents before their children
+	Colour4 mBackground;				//colour the damaged pixels are cleared to
+	bool mFullRedraw;					//the next update clears and redraws the whole framebuffer
+	std::vector<ClipRect> mDamage;		//disjoint damaged rectangles of the last update
+	SpatialGrid mGrid;					//shown nodes indexed by their bounds, sized at the first update
+	std::vector<int> mVisible;			//scratch storage for the nodes returned by a grid query
+
+	//Add a node and return its index
+	int AddNode(int parent, SceneRecordType type, int param);
+
+	//Mark a node as changed
+	inline void Touch(int node) { mNodes[node].dirty = true; }
+
+	//Recompute a node's world geometry and bounds from its parent
+	void TransformNode(SceneNode &node);
+
+	//Add a rectangle to the damage of the current update, clipped to the framebuffer
+	void AddDamage(const ClipRect &rect);
+
+	//Merge overlapping damage rectangles
+	void MergeDamage();
+
+	//Get the summed area of the damage rectangles in pixels
+	long long DamageArea() const;
+
+	//Submit the primitive of a node to the rasterizer
+	void DrawNode(Rasterizer *rasterizer, const SceneNode &node);
+
+public:
+	//The damage of an update is redrawn as a whole frame if it covers more than this fraction of the framebuffer
+	static const float FULL_REDRAW_FRACTION;
+
+	SceneGraph();
+
+	//Remove every node, the next update redraws the whole framebuffer
+	void Clear();
+
+	//Set the colour of the background, which redraws the whole framebuffer
+	void SetBackground(const Colour4 &colour);
+
+	//Redraw the whole framebuffer at the next update, e.g. after drawing to it outside the scene
+	inline void Invalidate() { mFullRedraw = true; }
+
+	//Add nodes, every method returns the index of the new node
+	//input:	int parent --- index of the parent node, -1 for a top-level node
+	//New nodes are visible, untransformed and drawn with NO_BLEND and SOLID_FILLED
+	int AddGroup(int parent);
+	int AddLines(int parent, const Vertex2d *vertices, int count, int thickness = 1);
+	int AddUnfilledPolygon(int parent, const Vertex2d *vertices, int count);
+	int AddFilledPolygon(int parent, const Vertex2d *vertices, int count);
+	int AddInterpolatedPolygon(int parent, const Vertex2d *vertices, int count);
+	int AddCircles(int parent, const Circle2D *circles, int count, bool filled);
+
+	//Add a node for every polygon, line and circle of a scene, state records set the blend and fill mode of the following nodes
+	//input:	int parent --- index of the parent of the new nodes, -1 for top-level nodes
+	//			const SceneView &scene --- the scene to be added
+	void AddSceneView(int parent, const SceneView &scene);
+
+	//Change a node, the change is drawn by the next update
+	void SetTransform(int node, const Transform2D &transform);
+	void SetTint(int node, const Colour4 &tint);
+	void SetVisible(int node, bool visible);
+	void SetBlendMode(int node, Rasterizer::BlendMode mode);
+	void SetFillMode(int node, Rasterizer::FillMode mode);
+	void SetVertices(int node, const Vertex2d *vertices, int count);
+	void SetCircles(int node, const Circle2D *circles, int count);
+
+	inline int GetNodeCount() const { return (int)mNodes.size(); }
+	inline const SceneNode &GetNode(int node) const { return mNodes[node]; }
+
+	//Bring the framebuffer up to date with the scene, redrawing only the damaged pixels
+	//The rasterizer is left in NO_BLEND and SOLID_FILLED mode with its clip rectangle unchanged
+	//input:	Rasterizer *rasterizer --- the rasterizer owning the framebuffer, the same for every update
+	void Update(Rasterizer *rasterizer);
+
+	//Get the rectangles redrawn by the last update, the whole framebuffer after a full redraw
+	inline const std::vector<ClipRect> &GetDamage() const { return mDamage; }
+};
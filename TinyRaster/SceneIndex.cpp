@@ -0,0 +1,465 @@
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+#include "SceneIndex.h"
+#include "TraceEvents.h"
+
+//Pixels a primitive may reach past its vertices through coordinate truncation and anti-aliased edges
+static const float VIEWPORT_PADDING = 2.0f;
+
+struct centre_x_less_than_key
+{
+	inline bool operator() (const SceneIndexNode& node1, const SceneIndexNode& node2)
+	{
+		return (node1.minX + node1.maxX < node2.minX + node2.maxX);
+	}
+};
+
+struct centre_y_less_than_key
+{
+	inline bool operator() (const SceneIndexNode& node1, const SceneIndexNode& node2)
+	{
+		return (node1.minY + node1.maxY < node2.minY + node2.maxY);
+	}
+};
+
+//Order boxes so that every run of capacity consecutive boxes is compact: sort by x, cut into vertical slices
+//of whole runs and sort every slice by y
+static void SortTileRecursive(std::vector<SceneIndexNode> &boxes, int capacity)
+{
+	int runs = ((int)boxes.size() + capacity - 1) / capacity;
+	int slices = (int)ceil(sqrt((double)runs));
+	int sliceSize = ((runs + slices - 1) / slices) * capacity;
+
+	std::sort(boxes.begin(), boxes.end(), centre_x_less_than_key());
+
+	for (size_t first = 0; first < boxes.size(); first += sliceSize)
+	{
+		size_t last = std::min(first + sliceSize, boxes.size());
+
+		std::sort(boxes.begin() + first, boxes.begin() + last, centre_y_less_than_key());
+	}
+}
+
+//Group consecutive boxes into parents of at most capacity children
+static void PackLevel(const std::vector<SceneIndexNode> &children, int capacity, bool leaf, std::vector<SceneIndexNode> &parents)
+{
+	parents.clear();
+
+	for (size_t first = 0; first < children.size(); first += capacity)
+	{
+		size_t last = std::min(first + capacity, children.size());
+		SceneIndexNode parent = children[first];
+
+		for (size_t i = first + 1; i < last; i++)
+		{
+			parent.minX = std::min(parent.minX, children[i].minX);
+			parent.maxX = std::max(parent.maxX, children[i].maxX);
+			parent.minY = std::min(parent.minY, children[i].minY);
+			parent.maxY = std::max(parent.maxY, children[i].maxY);
+		}
+
+		parent.first = (int)first;
+		parent.count = (int)(last - first);
+		parent.leaf = leaf;
+		parents.push_back(parent);
+	}
+}
+
+SceneIndex::SceneIndex()
+{
+	mScene.vertices = NULL;
+	mScene.circles = NULL;
+	mScene.records = NULL;
+	mScene.vertexCount = 0;
+	mScene.circleCount = 0;
+	mScene.recordCount = 0;
+	mMaxThickness = 0.0f;
+	mMaxRadius = 0.0f;
+	mSimplifyTolerance = 0.0f;
+}
+
+void SceneIndex::Build(const SceneView &scene)
+{
+	TRACE_SCOPE_ARG("BuildSceneIndex", "records", scene.recordCount);
+
+	mScene = scene;
+	mItems.clear();
+	mLevels.clear();
+	mMaxThickness = 1.0f;
+	mMaxRadius = 0.0f;
+
+	int state = -1;
+
+	for (unsigned int r = 0; r < scene.recordCount; r++)
+	{
+		const SceneRecord &record = scene.records[r];
+
+		if (record.type == SCENE_STATE)
+		{
+			state = (int)r;
+			continue;
+		}
+
+		//lines and circles are indexed one by one, so their bounds stay tight
+		unsigned int step = record.type == SCENE_LINES ? 2 : record.type == SCENE_CIRCLES ? 1 : record.count;
+
+		for (unsigned int first = record.first; step > 0 && first + step <= record.first + record.count; first += step)
+		{
+			SceneIndexItem item;
+
+			item.record = r;
+			item.first = first;
+			item.count = step;
+			item.state = state;
+
+			if (record.type == SCENE_CIRCLES)
+			{
+				const Circle2D &circle = scene.circles[first];
+
+				//a circle's radius is scaled with the view, it is added to the viewport instead
+				item.minX = item.maxX = circle.centre[0];
+				item.minY = item.maxY = circle.centre[1];
+				mMaxRadius = std::max(mMaxRadius, circle.radius);
+			}
+			else
+			{
+				item.minX = item.minY = FLT_MAX;
+				item.maxX = item.maxY = -FLT_MAX;
+
+				for (unsigned int v = first; v < first + step; v++)
+				{
+					const Vector2 &p = scene.vertices[v].position;
+
+					item.minX = std::min(item.minX, p[0]);
+					item.maxX = std::max(item.maxX, p[0]);
+					item.minY = std::min(item.minY, p[1]);
+					item.maxY = std::max(item.maxY, p[1]);
+				}
+
+				if (record.type == SCENE_LINES)
+				{
+					mMaxThickness = std::max(mMaxThickness, (float)record.param);
+				}
+			}
+
+			mItems.push_back(item);
+		}
+	}
+
+	BuildTree();
+}
+
+void SceneIndex::BuildTree()
+{
+	mEntries.clear();
+	mNodes.clear();
+
+	if (mItems.empty())
+	{
+		return;
+	}
+
+	std::vector<SceneIndexNode> boxes(mItems.size());
+
+	for (size_t i = 0; i < mItems.size(); i++)
+	{
+		boxes[i].minX = mItems[i].minX;
+		boxes[i].maxX = mItems[i].maxX;
+		boxes[i].minY = mItems[i].minY;
+		boxes[i].maxY = mItems[i].maxY;
+		boxes[i].first = (int)i;
+		boxes[i].count = 1;
+		boxes[i].leaf = true;
+	}
+
+	SortTileRecursive(boxes, NODE_CAPACITY);
+
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		mEntries.push_back(boxes[i].first);
+	}
+
+	//every level is packed from the sorted level below it; a node's children are consecutive in that level
+	std::vector<std::vector<SceneIndexNode> > levels(1);
+
+	PackLevel(boxes, NODE_CAPACITY, true, levels[0]);
+
+	while (levels.back().size() > 1)
+	{
+		std::vector<SceneIndexNode> &children = levels.back();
+		std::vector<SceneIndexNode> parents;
+
+		SortTileRecursive(children, NODE_CAPACITY);
+		PackLevel(children, NODE_CAPACITY, false, parents);
+		levels.push_back(parents);
+	}
+
+	//concatenate the levels, the children of an inner node move by the offset of their level
+	int offset = 0;
+
+	for (size_t l = 0; l < levels.size(); l++)
+	{
+		for (size_t n = 0; n < levels[l].size(); n++)
+		{
+			SceneIndexNode node = levels[l][n];
+
+			if (l > 0)
+			{
+				node.first += offset - (int)levels[l - 1].size();
+			}
+
+			mNodes.push_back(node);
+		}
+
+		offset += (int)levels[l].size();
+	}
+}
+
+void SceneIndex::Query(float minX, float maxX, float minY, float maxY, std::vector<int> &items)
+{
+	items.clear();
+
+	if (mNodes.empty())
+	{
+		return;
+	}
+
+	mStack.clear();
+	mStack.push_back((int)mNodes.size() - 1);
+
+	while (!mStack.empty())
+	{
+		const SceneIndexNode &node = mNodes[mStack.back()];
+
+		mStack.pop_back();
+
+		if (node.maxX < minX || node.minX > maxX || node.maxY < minY || node.minY > maxY)
+		{
+			continue;
+		}
+
+		if (!node.leaf)
+		{
+			for (int c = 0; c < node.count; c++)
+			{
+				mStack.push_back(node.first + c);
+			}
+
+			continue;
+		}
+
+		for (int e = node.first; e < node.first + node.count; e++)
+		{
+			const SceneIndexItem &item = mItems[mEntries[e]];
+
+			if (item.maxX >= minX && item.minX <= maxX && item.maxY >= minY && item.minY <= maxY)
+			{
+				items.push_back(mEntries[e]);
+			}
+		}
+	}
+
+	std::sort(items.begin(), items.end());
+}
+
+void SceneIndex::QueryViewport(const Transform2D &view, const ClipRect &rect, std::vector<int> &items)
+{
+	Transform2D inverse;
+
+	if (!view.Inverse(inverse))
+	{
+		items.resize(mItems.size());
+
+		for (size_t i = 0; i < mItems.size(); i++)
+		{
+			items[i] = (int)i;
+		}
+
+		return;
+	}
+
+	//grow the viewport by the pixels a primitive may reach past its indexed bounds, then map it into the scene
+	float padding = VIEWPORT_PADDING + mMaxThickness + mMaxRadius * view.ScaleFactor();
+	Vector2 corners[4] = {
+		Vector2(rect.left - padding, rect.bottom - padding),
+		Vector2(rect.right + padding, rect.bottom - padding),
+		Vector2(rect.right + padding, rect.top + padding),
+		Vector2(rect.left - padding, rect.top + padding)
+	};
+
+	float minX = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float minY = FLT_MAX;
+	float maxY = -FLT_MAX;
+
+	for (int i = 0; i < 4; i++)
+	{
+		Vector2 p = inverse.Apply(corners[i]);
+
+		minX = std::min(minX, p[0]);
+		maxX = std::max(maxX, p[0]);
+		minY = std::min(minY, p[1]);
+		maxY = std::max(maxY, p[1]);
+	}
+
+	Query(minX, maxX, minY, maxY, items);
+}
+
+void SceneIndex::SetSimplifyTolerance(float pixels)
+{
+	mSimplifyTolerance = pixels > 0.0f ? pixels : 0.0f;
+	mLevels.clear();
+}
+
+SceneIndexLevel* SceneIndex::GetLevel(float scale)
+{
+	if (mSimplifyTolerance <= 0.0f || !(scale > 0.0f))
+	{
+		return NULL;
+	}
+
+	//scales in [2^(bucket - 1), 2^bucket) share a bucket, its tolerance holds at the largest of them
+	int bucket;
+
+	frexpf(scale, &bucket);
+
+	std::map<int, SceneIndexLevel>::iterator found = mLevels.find(bucket);
+
+	if (found != mLevels.end())
+	{
+		return &found->second;
+	}
+
+	SceneIndexLevel &level = mLevels[bucket];
+
+	level.tolerance = ldexpf(mSimplifyTolerance, -bucket);
+	level.first.assign(mItems.size(), -1);
+	level.count.assign(mItems.size(), 0);
+
+	return &level;
+}
+
+const Vertex2d* SceneIndex::GetSimplifiedPolygon(SceneIndexLevel &level, int item, int &count)
+{
+	if (level.first[item] < 0)
+	{
+		const SceneIndexItem &polygon = mItems[item];
+
+		level.first[item] = (int)level.vertices.size();
+		level.count[item] = mSimplifier.SimplifyContour(mScene.vertices + polygon.first, polygon.count, level.tolerance, level.vertices);
+	}
+
+	count = level.count[item];
+
+	return &level.vertices[level.first[item]];
+}
+
+void SceneIndex::DrawItems(Rasterizer *rasterizer, const std::vector<int> &items, SceneIndexLevel *level)
+{
+	int state = -1;
+
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		const SceneIndexItem &item = mItems[items[i]];
+		const SceneRecord &record = mScene.records[item.record];
+
+		//items come in submission order, so a state record only has to be applied when it changes
+		if (item.state != state && item.state >= 0)
+		{
+			const SceneRecord &stateRecord = mScene.records[item.state];
+
+			rasterizer->SetGeometryMode((Rasterizer::GeometryMode)stateRecord.first);
+			rasterizer->SetFillMode((Rasterizer::FillMode)stateRecord.count);
+			rasterizer->SetBlendMode((Rasterizer::BlendMode)stateRecord.param);
+			state = item.state;
+		}
+
+		const Vertex2d *vertices = mScene.vertices + item.first;
+
+		switch (record.type)
+		{
+		case SCENE_LINES:
+			rasterizer->DrawLine2D(vertices[0], vertices[1], record.param);
+			break;
+		case SCENE_UNFILLED_POLYGON:
+			rasterizer->DrawUnfilledPolygon2D(vertices, item.count);
+			break;
+		case SCENE_FILLED_POLYGON:
+			if (level && item.count > 3)
+			{
+				int count;
+				const Vertex2d *simplified = GetSimplifiedPolygon(*level, items[i], count);
+
+				rasterizer->ScanlineFillPolygon2D(simplified, count);
+			}
+			else
+			{
+				rasterizer->ScanlineFillPolygon2D(vertices, item.count);
+			}
+			break;
+		case SCENE_INTERPOLATED_POLYGON:
+			rasterizer->ScanlineInterpolatedFillPolygon2D(vertices, item.count);
+			break;
+		case SCENE_CIRCLES:
+			rasterizer->SetFGColour(mScene.circles[item.first].colour);
+			rasterizer->DrawCircle2D(mScene.circles[item.first], record.param != 0);
+			break;
+		}
+	}
+}
+
+void SceneIndex::Draw(Rasterizer *rasterizer, const Transform2D &view)
+{
+	const ClipRect &clip = rasterizer->GetClipRectangle();
+	ClipRect viewport;
+
+	viewport.left = std::max(clip.left, 0);
+	viewport.right = std::min(clip.right, rasterizer->Width());
+	viewport.bottom = std::max(clip.bottom, 0);
+	viewport.top = std::min(clip.top, rasterizer->Height());
+
+	if (viewport.left >= viewport.right || viewport.bottom >= viewport.top)
+	{
+		return;
+	}
+
+	QueryViewport(view, viewport, mVisible);
+
+	TRACE_SCOPE_ARG("DrawSceneIndex", "primitives", (int)mVisible.size());
+
+	rasterizer->PushTransform();
+	rasterizer->SetTransform(view);
+
+	DrawItems(rasterizer, mVisible, GetLevel(view.ScaleFactor()));
+
+	rasterizer->PopTransform();
+}
+
+void SceneIndex::DrawTiled(Rasterizer *rasterizer, const Transform2D &view, int tileSize)
+{
+	ClipRect clip = rasterizer->GetClipRectangle();
+	int left = std::max(clip.left, 0);
+	int right = std::min(clip.right, rasterizer->Width());
+	int bottom = std::max(clip.bottom, 0);
+	int top = std::min(clip.top, rasterizer->Height());
+
+	tileSize = std::max(tileSize, 1);
+
+	int tile = 0;
+
+	//the tiles are disjoint, so every pixel of a primitive spanning several tiles is still drawn once
+	for (int y = bottom; y < top; y += tileSize)
+	{
+		for (int x = left; x < right; x += tileSize, tile++)
+		{
+			TRACE_SCOPE_ARG("DrawTile", "tile", tile);
+
+			rasterizer->SetClipRectangle(x, std::min(x + tileSize, right), y, std::min(y + tileSize, top));
+			Draw(rasterizer, view);
+		}
+	}
+
+	rasterizer->SetClipRectangle(clip.left, clip.right, clip.bottom, clip.top);
+}
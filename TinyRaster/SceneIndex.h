@@ -0,0 +1,120 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include "Rasterizer.h"
+#include "SceneFile.h"
+#include "Transform2D.h"
+
+//A primitive of an indexed scene: a polygon, one line of a lines record or one circle
+typedef struct _SceneIndexItem
+{
+	unsigned int record;			//index of the record holding the primitive
+	unsigned int first;				//index of its first vertex, or of its circle, in the scene's pools
+	unsigned int count;				//number of vertices, 1 for a circle
+	int state;						//index of the state record in effect for the primitive, -1 if none precedes it
+	float minX, maxX, minY, maxY;	//bounds of its vertices, or the position of a circle's centre
+} SceneIndexItem;
+
+//A node of the R-tree of an indexed scene
+typedef struct _SceneIndexNode
+{
+	float minX, maxX, minY, maxY;	//bounds of every primitive below the node
+	int first;						//index of the first child node, or of the first leaf entry for a leaf
+	int count;						//number of children or leaf entries
+	bool leaf;						//the node lists primitives rather than nodes
+} SceneIndexNode;
+
+//The filled polygons of an indexed scene simplified for the view scales of one zoom bucket
+typedef struct _SceneIndexLevel
+{
+	float tolerance;				//simplification tolerance in scene units
+	std::vector<Vertex2d> vertices;	//simplified polygons one after another
+	std::vector<int> first;			//per item, index of its first simplified vertex, -1 until it is first drawn
+	std::vector<int> count;			//per item, number of simplified vertices
+} SceneIndexLevel;
+
+//This class indexes the primitives of a large static scene, e.g. a world map, so a viewport only visits
+//the primitives that can reach it. The primitives are bulk loaded once into an R-tree packed with the
+//Sort-Tile-Recursive algorithm; a query walks the nodes overlapping the viewport in O(log n + k) and
+//returns the primitives in submission order, so a drawn viewport matches drawing the whole scene.
+//Primitives are indexed in the scene's own coordinates and drawn through a view transform; line thickness
+//and circle radii are accounted for in framebuffer pixels, so the index stays valid for any pan and zoom.
+class SceneIndex
+{
+private:
+	SceneView mScene;							//the indexed scene, not owned
+	std::vector<SceneIndexItem> mItems;			//primitives in submission order
+	std::vector<int> mEntries;					//indices into mItems in leaf order
+	std::vector<SceneIndexNode> mNodes;			//nodes level by level from the leaves, the root is the last node
+	float mMaxThickness;						//thickest line of the scene in pixels
+	float mMaxRadius;							//largest circle radius in scene units
+	std::vector<int> mStack;					//scratch storage for the nodes still to be visited by a query
+	std::vector<int> mVisible;					//scratch storage for the primitives of a viewport
+	float mSimplifyTolerance;					//largest simplification error in pixels, 0 when disabled
+	std::map<int, SceneIndexLevel> mLevels;		//simplified polygons by zoom bucket, filled as they are drawn
+	PolygonSimplifier mSimplifier;				//simplifies the polygons of the zoom buckets
+
+	//Pack the leaves and the levels above them
+	void BuildTree();
+
+	//Get the zoom bucket of a view scale, the polygons of a bucket are simplified once for all its scales
+	//output:	NULL if simplification is disabled
+	SceneIndexLevel* GetLevel(float scale);
+
+	//Get the vertices of a filled polygon simplified for a zoom bucket, simplifying it on first use
+	//output:	the vertices, valid until the next call; count receives their number
+	const Vertex2d* GetSimplifiedPolygon(SceneIndexLevel &level, int item, int &count);
+
+	//Draw primitives given by their indices in increasing order, applying the state records they follow
+	//input:	SceneIndexLevel *level --- the zoom bucket of the view, NULL to draw filled polygons unsimplified
+	void DrawItems(Rasterizer *rasterizer, const std::vector<int> &items, SceneIndexLevel *level);
+
+public:
+	//Maximum number of children of a node
+	static const int NODE_CAPACITY = 16;
+
+	//Edge length of the tiles drawn by DrawTiled() when none is given
+	static const int DEFAULT_TILE_SIZE = 256;
+
+	SceneIndex();
+
+	//Index every primitive of a scene, replacing any previous index and simplified polygons
+	//input:	const SceneView &scene --- the scene, which must outlive the index and stay unchanged
+	void Build(const SceneView &scene);
+
+	//Get the primitives whose bounds overlap a rectangle in scene coordinates
+	//output:	std::vector<int> &items --- cleared and filled with indices into the items, in increasing order
+	void Query(float minX, float maxX, float minY, float maxY, std::vector<int> &items);
+
+	//Get the primitives that may cover any pixel of a framebuffer rectangle under a view transform
+	//input:	const Transform2D &view --- transform from scene coordinates to the framebuffer
+	//			const ClipRect &rect --- the pixels of the viewport or tile
+	//output:	std::vector<int> &items --- as Query; every primitive if the view is singular
+	void QueryViewport(const Transform2D &view, const ClipRect &rect, std::vector<int> &items);
+
+	//Draw the primitives that reach the rasterizer's clip rectangle with a view transform
+	//Unfilled circles are drawn in their own colour. The rasterizer's transform is restored afterwards and
+	//its modes are left as set by the last state record drawn.
+	//input:	Rasterizer *rasterizer --- the rasterizer to draw with
+	//			const Transform2D &view --- transform from scene coordinates to the framebuffer
+	void Draw(Rasterizer *rasterizer, const Transform2D &view);
+
+	//Set the largest distance in pixels between the outline of a drawn filled polygon and its dropped vertices
+	//Filled polygons are simplified per zoom bucket, a power of two of the view scale, the first time a view of
+	//that bucket draws them and reused by later views, so panning and zooming within a bucket never simplify again.
+	//0, the default, draws every vertex; changing the tolerance discards the simplified polygons.
+	void SetSimplifyTolerance(float pixels);
+
+	inline float GetSimplifyTolerance() const { return mSimplifyTolerance; }
+
+	//Draw as Draw, binning the clip rectangle into square tiles that each visit only their own primitives
+	//Primitives are clipped to every tile they overlap, so the result equals a single Draw
+	//input:	int tileSize --- edge length of a tile in pixels
+	void DrawTiled(Rasterizer *rasterizer, const Transform2D &view, int tileSize = DEFAULT_TILE_SIZE);
+
+	inline int GetItemCount() const { return (int)mItems.size(); }
+	inline const SceneIndexItem &GetItem(int item) const { return mItems[item]; }
+	inline int GetNodeCount() const { return (int)mNodes.size(); }
+	inline int GetLevelCount() const { return (int)mLevels.size(); }
+};
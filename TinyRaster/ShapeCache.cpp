@@ -0,0 +1,104 @@
+#include <string.h>
+
+#include "ShapeCache.h"
+
+ShapeCache::ShapeCache(int capacity)
+{
+	mCapacity = capacity;
+	mHits = 0;
+	mMisses = 0;
+	mEvictions = 0;
+}
+
+unsigned long long ShapeCache::Hash(const std::vector<float> &key)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < key.size(); i++)
+	{
+		unsigned int bits;
+
+		memcpy(&bits, &key[i], sizeof(bits));
+
+		for (int b = 0; b < 4; b++)
+		{
+			hash ^= (bits >> (b * 8)) & 0xff;
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	return hash;
+}
+
+void ShapeCache::SetCapacity(int capacity)
+{
+	mCapacity = capacity < 0 ? 0 : capacity;
+
+	while ((int)mEntries.size() > mCapacity)
+	{
+		mIndex.erase(mEntries.back().hash);
+		mEntries.pop_back();
+		mEvictions++;
+	}
+}
+
+void ShapeCache::Clear()
+{
+	mEntries.clear();
+	mIndex.clear();
+}
+
+const SpanList *ShapeCache::Find(const std::vector<float> &key)
+{
+	if (mCapacity == 0)
+	{
+		return NULL;
+	}
+
+	std::unordered_map<unsigned long long, std::list<ShapeCacheEntry>::iterator>::iterator found = mIndex.find(Hash(key));
+
+	if (found == mIndex.end() || found->second->key != key)
+	{
+		mMisses++;
+		return NULL;
+	}
+
+	mEntries.splice(mEntries.begin(), mEntries, found->second);
+	mHits++;
+
+	return &mEntries.front().spans;
+}
+
+SpanList *ShapeCache::Insert(const std::vector<float> &key)
+{
+	if (mCapacity == 0)
+	{
+		return NULL;
+	}
+
+	unsigned long long hash = Hash(key);
+	std::unordered_map<unsigned long long, std::list<ShapeCacheEntry>::iterator>::iterator found = mIndex.find(hash);
+
+	//a different shape with the same hash gives up its entry
+	if (found != mIndex.end())
+	{
+		mEntries.erase(found->second);
+		mIndex.erase(found);
+	}
+	else if ((int)mEntries.size() >= mCapacity)
+	{
+		mIndex.erase(mEntries.back().hash);
+		mEntries.pop_back();
+		mEvictions++;
+	}
+
+	mEntries.push_front(ShapeCacheEntry());
+
+	ShapeCacheEntry &entry = mEntries.front();
+
+	entry.hash = hash;
+	entry.key = key;
+	mIndex[hash] = mEntries.begin();
+
+	return &entry.spans;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include "SpanList.h"
+
+//A cached shape, its key and its spans relative to the shape's origin
+typedef struct _ShapeCacheEntry
+{
+	unsigned long long hash;		//hash of the key
+	std::vector<float> key;			//parameters of the shape, compared in full on lookup
+	SpanList spans;					//spans captured when the shape was first drawn
+} ShapeCacheEntry;
+
+//This class keeps the span lists of recently drawn shapes, so a shape drawn again is replayed
+//without building and sorting its edges. Shapes are identified by a key of floats chosen by the caller,
+//typically the fill mode followed by the positions relative to an integer origin, so a translated
+//shape shares the entry of the original. When the cache is full the least recently used entry is dropped.
+class ShapeCache
+{
+private:
+	int mCapacity;										//maximum number of entries, 0 disables the cache
+	std::list<ShapeCacheEntry> mEntries;				//entries, most recently used first
+	std::unordered_map<unsigned long long, std::list<ShapeCacheEntry>::iterator> mIndex;	//entries by hash of their key
+	unsigned long long mHits;							//lookups that found their shape
+	unsigned long long mMisses;							//lookups that did not
+	unsigned long long mEvictions;						//entries dropped to make room for new ones
+
+	//Hash a key with 64-bit FNV-1a
+	static unsigned long long Hash(const std::vector<float> &key);
+
+public:
+	ShapeCache(int capacity = 0);
+
+	//Set the maximum number of entries, dropping the least recently used ones if there are more
+	void SetCapacity(int capacity);
+	inline int GetCapacity() const { return mCapacity; }
+
+	//Remove every entry, the counters are kept
+	void Clear();
+
+	//Look up a shape and mark it as most recently used
+	//input:	const std::vector<float> &key --- parameters of the shape
+	//output:	the spans of the shape, valid until the next Insert, or NULL on a miss
+	const SpanList *Find(const std::vector<float> &key);
+
+	//Add an entry for a shape that Find did not return, dropping the least recently used entry if the cache is full
+	//input:	const std::vector<float> &key --- parameters of the shape
+	//output:	an empty span list for the caller to fill, valid until the next Insert, or NULL if the cache is disabled
+	SpanList *Insert(const std::vector<float> &key);
+
+	inline int GetSize() const { return (int)mEntries.size(); }
+	inline unsigned long long GetHits() const { return mHits; }
+	inline unsigned long long GetMisses() const { return mMisses; }
+	inline unsigned long long GetEvictions() const { return mEvictions; }
+};
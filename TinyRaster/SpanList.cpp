@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <limits.h>
+
+#include "SpanList.h"
+
+struct span_less_than_key
+{
+	inline bool operator() (const Span& span1, const Span& span2)
+	{
+		return span1.y < span2.y || (span1.y == span2.y && span1.x0 < span2.x0);
+	}
+};
+
+//Append a span, extending the last span instead if it ends where the new one starts with the same coverage
+static inline void AppendSpan(std::vector<Span> &out, const Span &span)
+{
+	if (!out.empty())
+	{
+		Span &last = out.back();
+
+		if (last.y == span.y && last.x1 == span.x0 && last.coverage == span.coverage)
+		{
+			last.x1 = span.x1;
+			return;
+		}
+	}
+
+	out.push_back(span);
+}
+
+const float SpanList::COVERAGE_EPSILON = 1.0f / 4096.0f;
+
+//Snap coverage close to 0 or 1
+static inline float SnapCoverage(float coverage)
+{
+	if (coverage <= SpanList::COVERAGE_EPSILON)
+	{
+		return 0.0f;
+	}
+
+	return coverage >= 1.0f - SpanList::COVERAGE_EPSILON ? 1.0f : coverage;
+}
+
+SpanList::SpanList()
+{
+	Clear();
+}
+
+void SpanList::Clear()
+{
+	mSpans.clear();
+	mRowStarts.clear();
+	mMinY = 0;
+	mMaxY = -1;
+	mFinished = true;
+}
+
+void SpanList::Add(int y, int x0, int x1, float coverage)
+{
+	if (x0 >= x1 || coverage <= 0.0f)
+	{
+		return;
+	}
+
+	Span span = { y, x0, x1, std::min(coverage, 1.0f) };
+
+	mSpans.push_back(span);
+	mFinished = false;
+}
+
+void SpanList::AddCoverageRow(int x, int y, const float *coverage, int count)
+{
+	int i = 0;
+
+	while (i < count)
+	{
+		int start = i;
+		float value = SnapCoverage(coverage[i]);
+
+		while (i < count && SnapCoverage(coverage[i]) == value)
+		{
+			i++;
+		}
+
+		Add(y, x + start, x + i, value);
+	}
+}
+
+void SpanList::CombineRows(const Span *a, int aCount, const Span *b, int bCount, int y, Combine combine, std::vector<Span> &out)
+{
+	int ia = 0;
+	int ib = 0;
+	int x = INT_MAX;
+
+	if (aCount > 0)
+	{
+		x = a[0].x0;
+	}
+
+	if (bCount > 0)
+	{
+		x = std::min(x, b[0].x0);
+	}
+
+	//walk the boundaries of both rows, the coverage of either row is constant between two boundaries
+	while (ia < aCount || ib < bCount)
+	{
+		while (ia < aCount && a[ia].x1 <= x) { ia++; }
+		while (ib < bCount && b[ib].x1 <= x) { ib++; }
+
+		if (ia == aCount && ib == bCount)
+		{
+			break;
+		}
+
+		float ca = 0.0f;
+		float cb = 0.0f;
+		int next = INT_MAX;
+
+		if (ia < aCount)
+		{
+			ca = a[ia].x0 <= x ? a[ia].coverage : 0.0f;
+			next = a[ia].x0 <= x ? a[ia].x1 : a[ia].x0;
+		}
+
+		if (ib < bCount)
+		{
+			cb = b[ib].x0 <= x ? b[ib].coverage : 0.0f;
+			next = std::min(next, b[ib].x0 <= x ? b[ib].x1 : b[ib].x0);
+		}
+
+		float coverage = combine == UNITE ? ca + cb - ca * cb : ca * cb;
+
+		if (coverage > 0.0f)
+		{
+			Span span = { y, x, next, coverage };
+
+			AppendSpan(out, span);
+		}
+
+		x = next;
+	}
+}
+
+void SpanList::Finish()
+{
+	if (mFinished)
+	{
+		return;
+	}
+
+	std::sort(mSpans.begin(), mSpans.end(), span_less_than_key());
+
+	std::vector<Span> merged;
+	std::vector<Span> overlap;
+	size_t rowStart = 0;
+
+	merged.reserve(mSpans.size());
+
+	for (size_t i = 0; i < mSpans.size(); i++)
+	{
+		const Span &span = mSpans[i];
+
+		if (i == 0 || span.y != mSpans[i - 1].y)
+		{
+			rowStart = merged.size();
+		}
+
+		//the merged spans of the row are disjoint and sorted, only those at its end can overlap the new span
+		size_t tail = merged.size();
+
+		while (tail > rowStart && merged[tail - 1].x1 > span.x0)
+		{
+			tail--;
+		}
+
+		if (tail == merged.size())
+		{
+			AppendSpan(merged, span);
+			continue;
+		}
+
+		overlap.assign(merged.begin() + tail, merged.end());
+		merged.resize(tail);
+		CombineRows(&overlap[0], (int)overlap.size(), &span, 1, span.y, UNITE, merged);
+	}
+
+	mSpans.swap(merged);
+	IndexRows();
+	mFinished = true;
+}
+
+void SpanList::IndexRows()
+{
+	mRowStarts.clear();
+
+	if (mSpans.empty())
+	{
+		mMinY = 0;
+		mMaxY = -1;
+		return;
+	}
+
+	mMinY = mSpans.front().y;
+	mMaxY = mSpans.back().y;
+
+	size_t index = 0;
+
+	for (int y = mMinY; y <= mMaxY + 1; y++)
+	{
+		while (index < mSpans.size() && mSpans[index].y < y)
+		{
+			index++;
+		}
+
+		mRowStarts.push_back((int)index);
+	}
+}
+
+const Span *SpanList::GetRow(int y, int &count) const
+{
+	count = 0;
+
+	if (y < mMinY || y > mMaxY)
+	{
+		return NULL;
+	}
+
+	int start = mRowStarts[y - mMinY];
+
+	count = mRowStarts[y - mMinY + 1] - start;
+
+	return count > 0 ? &mSpans[start] : NULL;
+}
+
+bool SpanList::GetBounds(int &minX, int &minY, int &maxX, int &maxY) const
+{
+	if (mSpans.empty())
+	{
+		return false;
+	}
+
+	minX = INT_MAX;
+	maxX = INT_MIN;
+
+	for (size_t i = 0; i < mSpans.size(); i++)
+	{
+		minX = std::min(minX, mSpans[i].x0);
+		maxX = std::max(maxX, mSpans[i].x1);
+	}
+
+	minY = mMinY;
+	maxY = mMaxY + 1;
+
+	return true;
+}
+
+void SpanList::Translate(int dx, int dy)
+{
+	for (size_t i = 0; i < mSpans.size(); i++)
+	{
+		mSpans[i].x0 += dx;
+		mSpans[i].x1 += dx;
+		mSpans[i].y += dy;
+	}
+
+	if (!mSpans.empty())
+	{
+		mMinY += dy;
+		mMaxY += dy;
+	}
+}
+
+void SpanList::CombineLists(const SpanList &a, const SpanList &b, Combine combine, SpanList &out)
+{
+	out.Clear();
+
+	if (a.IsEmpty() || b.IsEmpty())
+	{
+		if (combine == UNITE)
+		{
+			out = a.IsEmpty() ? b : a;
+		}
+
+		return;
+	}
+
+	int minY = combine == UNITE ? std::min(a.mMinY, b.mMinY) : std::max(a.mMinY, b.mMinY);
+	int maxY = combine == UNITE ? std::max(a.mMaxY, b.mMaxY) : std::min(a.mMaxY, b.mMaxY);
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		int aCount, bCount;
+		const Span *aRow = a.GetRow(y, aCount);
+		const Span *bRow = b.GetRow(y, bCount);
+
+		CombineRows(aRow, aCount, bRow, bCount, y, combine, out.mSpans);
+	}
+
+	out.IndexRows();
+	out.mFinished = true;
+}
+
+void SpanList::Intersect(const SpanList &a, const SpanList &b, SpanList &out)
+{
+	CombineLists(a, b, INTERSECT, out);
+}
+
+void SpanList::Unite(const SpanList &a, const SpanList &b, SpanList &out)
+{
+	CombineLists(a, b, UNITE, out);
+}
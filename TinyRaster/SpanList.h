@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+
+//A run of pixels [x0, x1) in row y sharing one coverage value
+typedef struct _Span
+{
+	int y;					//row of the span
+	int x0;					//first pixel of the span
+	int x1;					//one past the last pixel of the span
+	float coverage;			//fraction of every pixel covered by the shape, in (0,1]
+} Span;
+
+//This class holds a rasterized shape as rows of spans, independent of its colour.
+//Spans may be added in any order; Finish() sorts them by row and x, merges overlapping spans
+//and indexes the rows. A finished list can be translated, intersected or united with another list,
+//and replayed any number of times by Rasterizer::FillSpans() without processing the shape's edges again.
+//Overlapping coverage combines as a + b - a * b, intersected coverage as a * b.
+class SpanList
+{
+public:
+	static const float COVERAGE_EPSILON;	//coverage within this distance of 0 or 1 is treated as empty or full
+
+private:
+	std::vector<Span> mSpans;			//the spans, sorted by row and x once finished
+	std::vector<int> mRowStarts;		//index of the first span of every row from mMinY, one extra entry at the end
+	int mMinY;							//first row holding a span
+	int mMaxY;							//last row holding a span
+	bool mFinished;						//true if mSpans is sorted, merged and indexed
+
+	//enum for the ways coverage of two rows is combined
+	enum Combine {
+		UNITE = 0,
+		INTERSECT
+	};
+
+	//Combine two sorted rows of disjoint spans
+	//input:	const Span *a, int aCount, const Span *b, int bCount --- the rows
+	//			Combine combine --- how overlapping coverage is combined
+	//output:	std::vector<Span> &out --- receives the combined spans of row y, appended in increasing x
+	static void CombineRows(const Span *a, int aCount, const Span *b, int bCount, int y, Combine combine, std::vector<Span> &out);
+
+	//Combine two finished lists row by row
+	static void CombineLists(const SpanList &a, const SpanList &b, Combine combine, SpanList &out);
+
+	//Build mRowStarts from the sorted spans
+	void IndexRows();
+
+public:
+	SpanList();
+
+	//Remove every span
+	void Clear();
+
+	//Add a span, the list must be finished again before it is read
+	//input:	int y --- row of the span
+	//			int x0, int x1 --- first and one past the last pixel, empty spans are ignored
+	//			float coverage --- coverage of the pixels, spans with zero coverage are ignored
+	void Add(int y, int x0, int x1, float coverage = 1.0f);
+
+	//Add a row of per-pixel coverage, runs of equal coverage become one span
+	//Coverage within COVERAGE_EPSILON of 0 or 1 is snapped, so accumulation round-off does not split interior runs
+	//input:	int x, int y --- first pixel of the row
+	//			const float *coverage --- count coverage values in [0,1]
+	//			int count --- number of pixels
+	void AddCoverageRow(int x, int y, const float *coverage, int count);
+
+	//Sort and merge the spans so the list can be read, translated or combined
+	void Finish();
+
+	inline bool IsEmpty() const { return mSpans.empty(); }
+	inline bool IsFinished() const { return mFinished; }
+	inline int GetSpanCount() const { return (int)mSpans.size(); }
+	inline const Span *GetSpans() const { return mSpans.empty() ? NULL : &mSpans[0]; }
+	inline int GetMinY() const { return mMinY; }
+	inline int GetMaxY() const { return mMaxY; }
+
+	//Get the spans of a row of a finished list
+	//output:	the first span of the row, and the number of spans in count, 0 for an empty row
+	const Span *GetRow(int y, int &count) const;
+
+	//Get the bounds of a finished list
+	//output:	the pixels [minX, maxX) x [minY, maxY), false if the list is empty
+	bool GetBounds(int &minX, int &minY, int &maxX, int &maxY) const;
+
+	//Move every span of a finished list
+	void Translate(int dx, int dy);
+
+	//Intersect two finished lists
+	//output:	SpanList &out --- the pixels covered by both lists, must not be one of the inputs
+	static void Intersect(const SpanList &a, const SpanList &b, SpanList &out);
+
+	//Unite two finished lists
+	//output:	SpanList &out --- the pixels covered by either list, must not be one of the inputs
+	static void Unite(const SpanList &a, const SpanList &b, SpanList &out);
+};
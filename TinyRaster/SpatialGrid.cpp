@@ -0,0 +1,133 @@
+#include <algorithm>
+
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid()
+{
+	mCellSize = DEFAULT_CELL_SIZE;
+	mColumns = 0;
+	mRows = 0;
+	mWidth = 0;
+	mHeight = 0;
+	mQuery = 0;
+}
+
+void SpatialGrid::Reset(int width, int height, int cellSize)
+{
+	mCellSize = std::max(cellSize, 1);
+	mWidth = std::max(width, 0);
+	mHeight = std::max(height, 0);
+	mColumns = (mWidth + mCellSize - 1) / mCellSize;
+	mRows = (mHeight + mCellSize - 1) / mCellSize;
+
+	mCells.assign(mColumns * mRows, std::vector<int>());
+	mVisited.clear();
+	mQuery = 0;
+}
+
+bool SpatialGrid::GetCellRange(const ClipRect &rect, int &col0, int &col1, int &row0, int &row1) const
+{
+	int left = std::max(rect.left, 0);
+	int right = std::min(rect.right, mWidth);
+	int bottom = std::max(rect.bottom, 0);
+	int top = std::min(rect.top, mHeight);
+
+	if (left >= right || bottom >= top)
+	{
+		return false;
+	}
+
+	col0 = left / mCellSize;
+	col1 = (right - 1) / mCellSize;
+	row0 = bottom / mCellSize;
+	row1 = (top - 1) / mCellSize;
+
+	return true;
+}
+
+void SpatialGrid::Insert(int item, const ClipRect &bounds)
+{
+	int col0, col1, row0, row1;
+
+	if (!GetCellRange(bounds, col0, col1, row0, row1))
+	{
+		return;
+	}
+
+	if ((int)mVisited.size() <= item)
+	{
+		mVisited.resize(item + 1, 0);
+	}
+
+	for (int row = row0; row <= row1; row++)
+	{
+		for (int col = col0; col <= col1; col++)
+		{
+			mCells[row * mColumns + col].push_back(item);
+		}
+	}
+}
+
+void SpatialGrid::Remove(int item, const ClipRect &bounds)
+{
+	int col0, col1, row0, row1;
+
+	if (!GetCellRange(bounds, col0, col1, row0, row1))
+	{
+		return;
+	}
+
+	//the order within a cell does not matter, queries sort their result
+	for (int row = row0; row <= row1; row++)
+	{
+		for (int col = col0; col <= col1; col++)
+		{
+			std::vector<int> &cell = mCells[row * mColumns + col];
+			std::vector<int>::iterator found = std::find(cell.begin(), cell.end(), item);
+
+			if (found != cell.end())
+			{
+				*found = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+}
+
+void SpatialGrid::Query(const ClipRect &rect, std::vector<int> &items)
+{
+	int col0, col1, row0, row1;
+
+	items.clear();
+
+	if (!GetCellRange(rect, col0, col1, row0, row1))
+	{
+		return;
+	}
+
+	//restart the query numbers before they wrap around
+	if (++mQuery == 0)
+	{
+		std::fill(mVisited.begin(), mVisited.end(), 0);
+		mQuery = 1;
+	}
+
+	for (int row = row0; row <= row1; row++)
+	{
+		for (int col = col0; col <= col1; col++)
+		{
+			const std::vector<int> &cell = mCells[row * mColumns + col];
+
+			for (size_t i = 0; i < cell.size(); i++)
+			{
+				if (mVisited[cell[i]] != mQuery)
+				{
+					mVisited[cell[i]] = mQuery;
+					items.push_back(cell[i]);
+				}
+			}
+		}
+	}
+
+	std::sort(items.begin(), items.end());
+}
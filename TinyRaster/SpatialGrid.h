@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include "Rasterizer.h"
+
+//This class is a coarse uniform grid over the framebuffer, indexing items such as scene nodes by their bounds.
+//Every item is listed in each cell its bounds overlap, the part of the bounds outside the framebuffer is dropped,
+//so items lying entirely off-screen are never returned by a query.
+class SpatialGrid
+{
+private:
+	int mCellSize;							//width and height of a cell in pixels
+	int mColumns;							//number of cells across the framebuffer
+	int mRows;								//number of cells up the framebuffer
+	int mWidth;								//width of the framebuffer covered by the grid
+	int mHeight;							//height of the framebuffer covered by the grid
+	std::vector<std::vector<int> > mCells;	//items overlapping each cell, row by row
+	std::vector<unsigned int> mVisited;		//query at which each item was last returned, to report it only once
+	unsigned int mQuery;					//number of the current query
+
+	//Get the cells [col0, col1] x [row0, row1] overlapped by a rectangle
+	//output:	false if the rectangle lies outside the framebuffer or is empty
+	bool GetCellRange(const ClipRect &rect, int &col0, int &col1, int &row0, int &row1) const;
+
+public:
+	//The cell size used when none is given, a few times the size of a typical primitive
+	static const int DEFAULT_CELL_SIZE = 64;
+
+	SpatialGrid();
+
+	//Remove every item and cover a framebuffer of the given size
+	void Reset(int width, int height, int cellSize = DEFAULT_CELL_SIZE);
+
+	//Add an item to the cells its bounds overlap
+	//input:	int item --- a non-negative index chosen by the caller
+	//			const ClipRect &bounds --- pixels the item covers
+	void Insert(int item, const ClipRect &bounds);
+
+	//Remove an item, bounds must be the ones it was inserted with
+	void Remove(int item, const ClipRect &bounds);
+
+	//Get the items whose cells overlap a rectangle, each once and in increasing order
+	//The items' own bounds must still be tested, as a cell is coarser than the rectangle
+	//input:	const ClipRect &rect --- the rectangle to be queried
+	//output:	std::vector<int> &items --- cleared and filled with the items
+	void Query(const ClipRect &rect, std::vector<int> &items);
+
+	inline int GetWidth() const { return mWidth; }
+	inline int GetHeight() const { return mHeight; }
+};
@@ -0,0 +1,96 @@
+#include <math.h>
+#include <algorithm>
+
+#include "TextRenderer.h"
+#include "TraceEvents.h"
+
+TextRenderer::TextRenderer()
+{
+	mFont.LoadBuiltin();
+}
+
+bool TextRenderer::LoadFont(const char *path)
+{
+	mAtlas.Flush();
+
+	if (!mFont.Load(path))
+	{
+		mFont.LoadBuiltin();
+		return false;
+	}
+
+	return true;
+}
+
+float TextRenderer::GetLineHeight(float size) const
+{
+	return size * (mFont.GetAscent() + mFont.GetDescent()) / mFont.GetUnitsPerEm();
+}
+
+float TextRenderer::DrawString(Rasterizer *rasterizer, const char *text, float x, float y, float size, const Colour4 &colour)
+{
+	TRACE_SCOPE("DrawString");
+
+	float penX = x;
+	float penY = y;
+	float width = 0.0f;
+
+	for (const char *c = text; *c; c++)
+	{
+		if (*c == '\n')
+		{
+			width = std::max(width, penX - x);
+			penX = x;
+			penY -= GetLineHeight(size);
+			continue;
+		}
+
+		const GlyphEntry *glyph = mAtlas.GetGlyph(mFont, (unsigned char)*c, size);
+
+		if (!glyph)
+		{
+			continue;
+		}
+
+		//glyphs are rasterized at the pen position rounded to whole pixels
+		if (glyph->width > 0)
+		{
+			int originX = (int)floorf(penX + 0.5f);
+			int originY = (int)floorf(penY + 0.5f);
+			const unsigned char *mask = mAtlas.GetPixels() + glyph->y * mAtlas.GetWidth() + glyph->x;
+
+			rasterizer->BlitCoverageMask(originX + glyph->left, originY + glyph->bottom, mask, glyph->width, glyph->height, mAtlas.GetWidth(), colour);
+		}
+
+		penX += glyph->advance;
+	}
+
+	return std::max(width, penX - x);
+}
+
+float TextRenderer::MeasureString(const char *text, float size)
+{
+	//the same quarter pixel size quantisation as the glyph atlas
+	float scale = floorf(size * 4.0f + 0.5f) / (4.0f * mFont.GetUnitsPerEm());
+	float lineWidth = 0.0f;
+	float width = 0.0f;
+
+	for (const char *c = text; *c; c++)
+	{
+		if (*c == '\n')
+		{
+			width = std::max(width, lineWidth);
+			lineWidth = 0.0f;
+			continue;
+		}
+
+		const GlyphOutline *glyph = mFont.GetGlyph((unsigned char)*c);
+
+		if (glyph)
+		{
+			lineWidth += glyph->advance * scale;
+		}
+	}
+
+	return std::max(width, lineWidth);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Rasterizer.h"
+#include "Font.h"
+#include "GlyphAtlas.h"
+
+//This class draws text with a vector font.
+//Every glyph is rasterized once per size into a glyph atlas, drawing text then only blits the cached
+//coverage masks through Rasterizer::BlitCoverageMask with the text colour and the rasterizer's blend mode.
+class TextRenderer
+{
+private:
+	Font		mFont;		//the font in use, the built-in font unless LoadFont succeeded
+	GlyphAtlas	mAtlas;		//cache of the rasterized glyphs of mFont
+
+public:
+	TextRenderer();
+
+	//Replace the font with a font file, see Font for the format
+	//input:	const char *path --- path of the font file
+	//output:	false if the font cannot be loaded, the built-in font is then used
+	bool LoadFont(const char *path);
+
+	//Draw a string, characters without a glyph are skipped and '\n' starts a new line below
+	//input:	Rasterizer *rasterizer --- the rasterizer to draw into
+	//			const char *text --- the string
+	//			float x, float y --- pen position of the first character on its baseline, in pixels
+	//			float size --- em size in pixels
+	//			const Colour4 &colour --- text colour
+	//output:	width of the widest line in pixels
+	float DrawString(Rasterizer *rasterizer, const char *text, float x, float y, float size, const Colour4 &colour);
+
+	//Measure a string without drawing it
+	//output:	width of the widest line in pixels
+	float MeasureString(const char *text, float size);
+
+	//Height of a line of text in pixels
+	float GetLineHeight(float size) const;
+};
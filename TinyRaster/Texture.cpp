@@ -0,0 +1,209 @@
+//the image loader uses the portable stdio functions rather than the _s variants
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <emmintrin.h>
+
+#include "Texture.h"
+
+static inline bool IsPowerOfTwo(int n)
+{
+	return n > 0 && (n & (n - 1)) == 0;
+}
+
+//Expand an RGBA8 texel to four floats in [0,1]
+static inline __m128 TexelToColour(unsigned int texel)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)texel), zero), zero);
+
+	return _mm_mul_ps(_mm_cvtepi32_ps(channels), _mm_set1_ps(1.0f / 255.0f));
+}
+
+//Round four floats towards negative infinity, SSE2 only truncates towards zero
+static inline __m128i Floor4(__m128 x)
+{
+	__m128i truncated = _mm_cvttps_epi32(x);
+	__m128 correction = _mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), x);
+
+	return _mm_add_epi32(truncated, _mm_castps_si128(correction));
+}
+
+static inline int Floor(float x)
+{
+	return (int)floorf(x);
+}
+
+Texture::Texture()
+{
+	mWidth = 0;
+	mHeight = 0;
+	mFilter = NEAREST;
+}
+
+bool Texture::Create(int width, int height, const unsigned char *rgba)
+{
+	if (!IsPowerOfTwo(width) || !IsPowerOfTwo(height))
+	{
+		return false;
+	}
+
+	mWidth = width;
+	mHeight = height;
+	mTexels.assign((size_t)width * height, 0);
+
+	if (rgba)
+	{
+		for (size_t i = 0; i < mTexels.size(); i++)
+		{
+			const unsigned char *texel = rgba + 4 * i;
+
+			mTexels[i] = texel[0] | (texel[1] << 8) | (texel[2] << 16) | ((unsigned int)texel[3] << 24);
+		}
+	}
+
+	return true;
+}
+
+bool Texture::Load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	int width = 0, height = 0, depth = 0, maxval = 0;
+	bool ok = fscanf(file, "P7 WIDTH %d HEIGHT %d DEPTH %d MAXVAL %d TUPLTYPE RGB_ALPHA ENDHDR", &width, &height, &depth, &maxval) == 4 &&
+		fgetc(file) == '\n' && depth == 4 && maxval == 255 && IsPowerOfTwo(width) && IsPowerOfTwo(height);
+	std::vector<unsigned char> image;
+
+	if (ok)
+	{
+		image.resize((size_t)width * height * 4);
+		ok = fread(&image[0], 1, image.size(), file) == image.size();
+	}
+
+	fclose(file);
+
+	if (!ok)
+	{
+		return false;
+	}
+
+	//the file stores the top row first, the texture the bottom row
+	std::vector<unsigned char> row(width * 4);
+
+	for (int y = 0; y < height / 2; y++)
+	{
+		unsigned char *top = &image[(size_t)y * width * 4];
+		unsigned char *bottom = &image[(size_t)(height - 1 - y) * width * 4];
+
+		memcpy(&row[0], top, row.size());
+		memcpy(top, bottom, row.size());
+		memcpy(bottom, &row[0], row.size());
+	}
+
+	return Create(width, height, &image[0]);
+}
+
+void Texture::SampleSpan(float u, float v, float dudx, float dvdx, int count, PixelRGBA *out) const
+{
+	float *colours = reinterpret_cast<float*>(out);
+	const unsigned int *texels = &mTexels[0];
+	int widthMask = mWidth - 1;
+	int heightMask = mHeight - 1;
+
+	//texel coordinates of the samples
+	float x = u * mWidth;
+	float y = v * mHeight;
+	float dx = dudx * mWidth;
+	float dy = dvdx * mHeight;
+
+	if (mFilter == BILINEAR)
+	{
+		//blend the four texels whose centres surround the sample
+		x -= 0.5f;
+		y -= 0.5f;
+
+		for (int i = 0; i < count; i++, x += dx, y += dy)
+		{
+			int x0 = Floor(x);
+			int y0 = Floor(y);
+			__m128 fx = _mm_set1_ps(x - x0);
+			__m128 fy = _mm_set1_ps(y - y0);
+			const unsigned int *row0 = texels + (y0 & heightMask) * mWidth;
+			const unsigned int *row1 = texels + ((y0 + 1) & heightMask) * mWidth;
+			int x1 = (x0 + 1) & widthMask;
+
+			x0 &= widthMask;
+
+			__m128 c00 = TexelToColour(row0[x0]);
+			__m128 c10 = TexelToColour(row0[x1]);
+			__m128 c01 = TexelToColour(row1[x0]);
+			__m128 c11 = TexelToColour(row1[x1]);
+			__m128 bottom = _mm_add_ps(c00, _mm_mul_ps(_mm_sub_ps(c10, c00), fx));
+			__m128 top = _mm_add_ps(c01, _mm_mul_ps(_mm_sub_ps(c11, c01), fx));
+
+			_mm_storeu_ps(colours + 4 * i, _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(top, bottom), fy)));
+		}
+
+		return;
+	}
+
+	if (dy == 0.0f && dx == 1.0f)
+	{
+		//one texel per sample along a texture row, as in an unscaled blit: walk the row without coordinate math
+		const unsigned int *row = texels + (Floor(y) & heightMask) * mWidth;
+		int tx = Floor(x);
+
+		for (int i = 0; i < count; i++)
+		{
+			_mm_storeu_ps(colours + 4 * i, TexelToColour(row[(tx + i) & widthMask]));
+		}
+
+		return;
+	}
+
+	//four samples per iteration, their texel indices are computed together
+	int shift = 0;
+
+	while ((1 << shift) < mWidth)
+	{
+		shift++;
+	}
+
+	__m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	__m128 xs = _mm_add_ps(_mm_set1_ps(x), _mm_mul_ps(lanes, _mm_set1_ps(dx)));
+	__m128 ys = _mm_add_ps(_mm_set1_ps(y), _mm_mul_ps(lanes, _mm_set1_ps(dy)));
+	__m128 xStep = _mm_set1_ps(4.0f * dx);
+	__m128 yStep = _mm_set1_ps(4.0f * dy);
+	__m128i xMask = _mm_set1_epi32(widthMask);
+	__m128i yMask = _mm_set1_epi32(heightMask);
+	int i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i tx = _mm_and_si128(Floor4(xs), xMask);
+		__m128i ty = _mm_and_si128(Floor4(ys), yMask);
+		int index[4];
+
+		_mm_storeu_si128((__m128i*)index, _mm_add_epi32(_mm_sll_epi32(ty, _mm_cvtsi32_si128(shift)), tx));
+
+		_mm_storeu_ps(colours + 4 * i, TexelToColour(texels[index[0]]));
+		_mm_storeu_ps(colours + 4 * i + 4, TexelToColour(texels[index[1]]));
+		_mm_storeu_ps(colours + 4 * i + 8, TexelToColour(texels[index[2]]));
+		_mm_storeu_ps(colours + 4 * i + 12, TexelToColour(texels[index[3]]));
+
+		xs = _mm_add_ps(xs, xStep);
+		ys = _mm_add_ps(ys, yStep);
+	}
+
+	for (x += i * dx, y += i * dy; i < count; i++, x += dx, y += dy)
+	{
+		_mm_storeu_ps(colours + 4 * i, TexelToColour(texels[(Floor(y) & heightMask) * mWidth + (Floor(x) & widthMask)]));
+	}
+}
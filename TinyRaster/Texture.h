@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include "TinyRasterTypes.h"
+
+//This class represents an RGBA8 image sampled by the textured fills.
+//Both sides must be powers of two so texture coordinates wrap with a mask, tiling the image.
+//Texture coordinates are normalised: (0, 0) is the bottom-left corner of the image and (1, 1) the top-right.
+class Texture
+{
+public:
+	//enum for texture filtering
+	enum Filter {
+		NEAREST = 0,				//the texel containing the sample position
+		BILINEAR					//weighted average of the four texels around the sample position
+	};
+
+private:
+	int mWidth;							//width of the image in texels
+	int mHeight;						//height of the image in texels
+	std::vector<unsigned int> mTexels;	//RGBA8 texels with red in the lowest byte, bottom row first
+	Filter mFilter;						//current filter
+
+public:
+	Texture();
+
+	//Create the image
+	//input:	int width, int height --- size of the image, both must be powers of two
+	//			const unsigned char *rgba --- 4 bytes per texel in RGBA order, bottom row first; NULL leaves the image transparent black
+	//output:	false if a size is not a power of two
+	bool Create(int width, int height, const unsigned char *rgba = NULL);
+
+	//Load the image from an 8-bit RGB_ALPHA PAM file as written by the regression suite, top row first
+	//output:	false if the file cannot be read or its size is not a power of two
+	bool Load(const char *path);
+
+	inline void SetFilter(Filter filter) { mFilter = filter; }
+	inline Filter GetFilter() const { return mFilter; }
+
+	inline int GetWidth() const { return mWidth; }
+	inline int GetHeight() const { return mHeight; }
+
+	//Get the texels for direct access, GetWidth() texels per row
+	inline unsigned int *GetTexels() { return mTexels.empty() ? NULL : &mTexels[0]; }
+
+	//Sample a horizontal run of pixels with a texture coordinate changing linearly along the run
+	//input:	float u, float v --- texture coordinate of the first sample
+	//			float dudx, float dvdx --- change of the texture coordinate from one sample to the next
+	//			int count --- number of samples
+	//output:	PixelRGBA *out --- receives count colours with components in [0,1]
+	void SampleSpan(float u, float v, float dudx, float dvdx, int count, PixelRGBA *out) const;
+};
@@ -21,6 +21,8 @@
 #include <gl/GLU.h>
 
 #include "TestApplication.h"
+#include "SceneFile.h"
+#include "RegressionSuite.h"
 
 #pragma comment (lib, "opengl32.lib")
 #pragma comment (lib, "glu32.lib")
@@ -36,6 +38,16 @@ void PrintUsage()
 	printf("F6: Test6: Filled polygons with alpha blending\n");
 	printf("F7: Test7: Gradient filled polygons using interpolated filling\n");
 	printf("F8: Test8: A mix of unfilled and filled circles.\n");
+	printf("A: Toggle analytic anti-aliasing\n");
+	printf("M: Toggle 4x multisample anti-aliasing\n");
+	printf("T: Toggle the tiled framebuffer layout\n");
+	printf("R: Toggle retained rendering, which redraws only the pixels the mouse line moves over\n");
+	printf("L: Toggle the simplification of filled polygons to half a pixel\n");
+	printf("Arrow keys: Pan the test, Page Up/Page Down: Zoom in/out, Home: Reset the view\n");
+	printf("\nTinyRaster.exe -convert <scene.txt> <scene.tscn> converts a text scene into a binary scene\n");
+	printf("TinyRaster.exe -record <dir> renders all tests into reference images and time budgets\n");
+	printf("TinyRaster.exe -regress <dir> checks all tests against the references in <dir>\n");
+	printf("TinyRaster.exe -benchmark <results.csv> measures throughput on generated stress scenes\n");
 }
 
 void ErrorExit(LPTSTR lpszFunction)
@@ -89,6 +101,52 @@ int APIENTRY WinMain(HINSTANCE hInstance,
 
 	PrintUsage();
 
+	//Convert a text scene to the binary scene format without starting the application
+	char textPath[MAX_PATH];
+	char binaryPath[MAX_PATH];
+
+	if (sscanf_s(lpCmdLine, "-convert %s %s", textPath, (unsigned)MAX_PATH, binaryPath, (unsigned)MAX_PATH) == 2)
+	{
+		char error[MAX_PATH + 512];
+
+		exitcode = SceneFile::ConvertTextScene(textPath, binaryPath, error, sizeof(error)) ? 0 : 1;
+		printf("Converting %s to %s %s\n", textPath, binaryPath, exitcode == 0 ? "succeeded" : "failed");
+
+		if (exitcode != 0)
+		{
+			printf("%s\n", error);
+		}
+
+		fclose(pf_out);
+		FreeConsole();
+
+		return exitcode;
+	}
+
+	//Run the headless regression suite without starting the application
+	char directory[MAX_PATH];
+	bool record = sscanf_s(lpCmdLine, "-record %s", directory, (unsigned)MAX_PATH) == 1;
+
+	if (record || sscanf_s(lpCmdLine, "-regress %s", directory, (unsigned)MAX_PATH) == 1)
+	{
+		exitcode = record ? RegressionSuite::Record(directory) : RegressionSuite::Check(directory);
+
+		fclose(pf_out);
+		FreeConsole();
+
+		return exitcode;
+	}
+
+	if (sscanf_s(lpCmdLine, "-benchmark %s", directory, (unsigned)MAX_PATH) == 1)
+	{
+		exitcode = RegressionSuite::Benchmark(directory);
+
+		fclose(pf_out);
+		FreeConsole();
+
+		return exitcode;
+	}
+
 	//Create the application instance
 	TestApplication* myapp = TestApplication::CreateApplication(hInstance);
 
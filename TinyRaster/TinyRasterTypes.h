@@ -24,6 +24,7 @@ typedef struct _Vertex2d
 {
 	Colour4 colour;					//Colour property of the vertex
 	Vector2 position;				//Coordinate (position) of the vertex
+	Vector2 uv;						//Texture coordinate of the vertex, only used by textured fills
 } Vertex2d;
 
 //struct for a 2D circle
@@ -0,0 +1,180 @@
+//the trace writer uses the portable stdio functions rather than the _s variants
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+
+#include "TraceEvents.h"
+
+namespace Trace
+{
+	//Ring buffer of events owned by one recording thread at a time
+	//Buffers are linked into a global list and live until the process exits, so events of threads that have finished
+	//can still be exported. A thread releases its buffer when it exits and the next thread to record takes it over,
+	//appending to the events already held, so the pool only grows to the largest number of threads recording at once.
+	struct ThreadBuffer
+	{
+		TraceEvent events[TRACE_BUFFER_CAPACITY];
+		std::atomic<unsigned long long> written;	//total number of events recorded into the buffer
+		std::atomic<bool> owned;					//true while a thread records into the buffer
+		int threadId;								//sequential id used as the trace tid
+		ThreadBuffer *next;
+	};
+
+	//Releases the buffer of a thread when the thread exits
+	struct ThreadBufferOwner
+	{
+		ThreadBuffer *buffer;
+
+		~ThreadBufferOwner()
+		{
+			if (buffer)
+			{
+				buffer->owned.store(false, std::memory_order_release);
+			}
+		}
+	};
+
+	static std::atomic<ThreadBuffer*> sBuffers(NULL);
+	static std::atomic<int> sNextThreadId(1);
+	static thread_local ThreadBufferOwner tOwner = { NULL };
+
+	static ThreadBuffer *GetThreadBuffer()
+	{
+		if (tOwner.buffer == NULL)
+		{
+			//take over a buffer released by a finished thread
+			for (ThreadBuffer *buffer = sBuffers.load(); buffer; buffer = buffer->next)
+			{
+				bool owned = false;
+
+				if (buffer->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+				{
+					tOwner.buffer = buffer;
+
+					return buffer;
+				}
+			}
+
+			ThreadBuffer *buffer = new ThreadBuffer;
+
+			buffer->written = 0;
+			buffer->owned = true;
+			buffer->threadId = sNextThreadId++;
+			buffer->next = sBuffers.load();
+
+			//lock-free push onto the global list
+			while (!sBuffers.compare_exchange_weak(buffer->next, buffer))
+			{
+			}
+
+			tOwner.buffer = buffer;
+		}
+
+		return tOwner.buffer;
+	}
+
+	//Write a string as a quoted JSON string, escaping quotes, backslashes and control characters
+	static void WriteJsonString(FILE *file, const char *text)
+	{
+		fputc('"', file);
+
+		for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				fputc('\\', file);
+				fputc(*c, file);
+			}
+			else if (*c < 0x20)
+			{
+				fprintf(file, "\\u%04x", *c);
+			}
+			else
+			{
+				fputc(*c, file);
+			}
+		}
+
+		fputc('"', file);
+	}
+
+	long long Now()
+	{
+		static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Record(const char *name, long long begin, long long end, const char *argName, long long argValue)
+	{
+		ThreadBuffer *buffer = GetThreadBuffer();
+		unsigned long long index = buffer->written.load(std::memory_order_relaxed);
+		TraceEvent &e = buffer->events[index % TRACE_BUFFER_CAPACITY];
+
+		e.name = name;
+		e.argName = argName;
+		e.argValue = argValue;
+		e.begin = begin;
+		e.end = end;
+
+		//publish the event to the exporting thread
+		buffer->written.store(index + 1, std::memory_order_release);
+	}
+
+	void Reset()
+	{
+		for (ThreadBuffer *buffer = sBuffers.load(); buffer; buffer = buffer->next)
+		{
+			buffer->written.store(0);
+		}
+	}
+
+	bool WriteChromeTrace(const char *path)
+	{
+		FILE *file = fopen(path, "w");
+
+		if (file == NULL)
+		{
+			return false;
+		}
+
+		fprintf(file, "{\"traceEvents\":[\n");
+
+		bool first = true;
+
+		for (ThreadBuffer *buffer = sBuffers.load(); buffer; buffer = buffer->next)
+		{
+			unsigned long long written = buffer->written.load(std::memory_order_acquire);
+			unsigned long long start = written > TRACE_BUFFER_CAPACITY ? written - TRACE_BUFFER_CAPACITY : 0;
+
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}",
+				first ? "" : ",\n", buffer->threadId, buffer->threadId);
+			first = false;
+
+			for (unsigned long long i = start; i < written; i++)
+			{
+				const TraceEvent &e = buffer->events[i % TRACE_BUFFER_CAPACITY];
+
+				fprintf(file, ",\n{\"name\":");
+				WriteJsonString(file, e.name);
+				fprintf(file, ",\"cat\":\"TinyRaster\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld",
+					buffer->threadId, e.begin, e.end - e.begin);
+
+				if (e.argName)
+				{
+					fprintf(file, ",\"args\":{");
+					WriteJsonString(file, e.argName);
+					fprintf(file, ":%lld}", e.argValue);
+				}
+
+				fprintf(file, "}");
+			}
+		}
+
+		fprintf(file, "\n]}\n");
+
+		return fclose(file) == 0;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+//Scoped trace events written in the Chrome trace JSON format (loadable in chrome://tracing and Perfetto).
+//Events are only recorded when TINYRASTER_ENABLE_TRACE is defined,
+//otherwise every TRACE_* macro expands to nothing.
+//
+//Each thread records into its own ring buffer holding the most recent TRACE_BUFFER_CAPACITY events,
+//so recording never takes a lock. The buffer of a finished thread keeps its events and is reused by the next
+//thread that starts recording. Names and argument names must be string literals, they are escaped in the JSON.
+
+const int TRACE_BUFFER_CAPACITY = 1 << 16;
+
+namespace Trace
+{
+	//struct for a single complete ("X") trace event
+	typedef struct _TraceEvent
+	{
+		const char *name;			//event name, a string literal
+		const char *argName;		//optional argument name, a string literal or NULL
+		long long argValue;			//value of the optional argument
+		long long begin;			//start time in microseconds
+		long long end;				//end time in microseconds
+	} TraceEvent;
+
+	//Current time in microseconds on the trace clock
+	long long Now();
+
+	//Append a completed event to the buffer of the calling thread
+	void Record(const char *name, long long begin, long long end, const char *argName, long long argValue);
+
+	//Discard all recorded events
+	//Must not be called while other threads are recording
+	void Reset();
+
+	//Write every recorded event of every thread to a Chrome trace JSON file
+	//Must not be called while other threads are recording
+	//input:	const char *path --- destination file
+	//output:	true if the file was written successfully
+	bool WriteChromeTrace(const char *path);
+
+	//Records an event spanning the lifetime of the object
+	class ScopedEvent
+	{
+	private:
+		const char *mName;
+		const char *mArgName;
+		long long mArgValue;
+		long long mBegin;
+
+	public:
+		inline ScopedEvent(const char *name, const char *argName = 0, long long argValue = 0)
+		{
+			mName = name;
+			mArgName = argName;
+			mArgValue = argValue;
+			mBegin = Now();
+		}
+
+		inline ~ScopedEvent()
+		{
+			Record(mName, mBegin, Now(), mArgName, mArgValue);
+		}
+	};
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef TINYRASTER_ENABLE_TRACE
+#define TRACE_SCOPE(name)							Trace::ScopedEvent TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, argName, argValue)	Trace::ScopedEvent TRACE_CONCAT(traceScope, __LINE__)(name, argName, (long long)(argValue))
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_ARG(name, argName, argValue)
+#endif
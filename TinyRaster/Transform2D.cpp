@@ -0,0 +1,132 @@
+#include <math.h>
+#include <xmmintrin.h>
+
+#include "Transform2D.h"
+
+static_assert(sizeof(Vector2) == 2 * sizeof(float), "Vector2 must be two packed floats");
+
+Transform2D::Transform2D()
+{
+	m_element[0] = 1.0f; m_element[1] = 0.0f; m_element[2] = 0.0f;
+	m_element[3] = 0.0f; m_element[4] = 1.0f; m_element[5] = 0.0f;
+}
+
+Transform2D::Transform2D(float xx, float xy, float tx, float yx, float yy, float ty)
+{
+	m_element[0] = xx; m_element[1] = xy; m_element[2] = tx;
+	m_element[3] = yx; m_element[4] = yy; m_element[5] = ty;
+}
+
+Transform2D Transform2D::Translation(float tx, float ty)
+{
+	return Transform2D(1.0f, 0.0f, tx, 0.0f, 1.0f, ty);
+}
+
+Transform2D Transform2D::Scale(float sx, float sy)
+{
+	return Transform2D(sx, 0.0f, 0.0f, 0.0f, sy, 0.0f);
+}
+
+Transform2D Transform2D::Rotation(float radians)
+{
+	float c = cosf(radians);
+	float s = sinf(radians);
+
+	return Transform2D(c, -s, 0.0f, s, c, 0.0f);
+}
+
+float Transform2D::operator [] (const int i) const
+{
+	return m_element[i];
+}
+
+float& Transform2D::operator [] (const int i)
+{
+	return m_element[i];
+}
+
+Transform2D Transform2D::operator * (const Transform2D& rhs) const
+{
+	return Transform2D(
+		m_element[0] * rhs[0] + m_element[1] * rhs[3],
+		m_element[0] * rhs[1] + m_element[1] * rhs[4],
+		m_element[0] * rhs[2] + m_element[1] * rhs[5] + m_element[2],
+		m_element[3] * rhs[0] + m_element[4] * rhs[3],
+		m_element[3] * rhs[1] + m_element[4] * rhs[4],
+		m_element[3] * rhs[2] + m_element[4] * rhs[5] + m_element[5]);
+}
+
+Vector2 Transform2D::Apply(const Vector2& p) const
+{
+	return Vector2(
+		m_element[0] * p[0] + m_element[1] * p[1] + m_element[2],
+		m_element[3] * p[0] + m_element[4] * p[1] + m_element[5]);
+}
+
+void Transform2D::Apply(const Vertex2d* src, Vertex2d* dst, int count) const
+{
+	//lanes hold x0 y0 x1 y1, so every coefficient is laid out as (x row, y row) twice
+	__m128 xScale = _mm_setr_ps(m_element[0], m_element[3], m_element[0], m_element[3]);
+	__m128 yScale = _mm_setr_ps(m_element[1], m_element[4], m_element[1], m_element[4]);
+	__m128 offset = _mm_setr_ps(m_element[2], m_element[5], m_element[2], m_element[5]);
+	int i = 0;
+
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128 p = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&src[i].position));
+
+		p = _mm_loadh_pi(p, reinterpret_cast<const __m64*>(&src[i + 1].position));
+
+		__m128 xs = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128 ys = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+		__m128 q = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, xScale), _mm_mul_ps(ys, yScale)), offset);
+
+		dst[i].colour = src[i].colour;
+		dst[i].uv = src[i].uv;
+		dst[i + 1].colour = src[i + 1].colour;
+		dst[i + 1].uv = src[i + 1].uv;
+
+		_mm_storel_pi(reinterpret_cast<__m64*>(&dst[i].position), q);
+		_mm_storeh_pi(reinterpret_cast<__m64*>(&dst[i + 1].position), q);
+	}
+
+	for (; i < count; i++)
+	{
+		Vector2 p = Apply(src[i].position);
+
+		dst[i].colour = src[i].colour;
+		dst[i].uv = src[i].uv;
+		dst[i].position = p;
+	}
+}
+
+bool Transform2D::Inverse(Transform2D& inverse) const
+{
+	float det = m_element[0] * m_element[4] - m_element[1] * m_element[3];
+
+	if (det == 0.0f)
+	{
+		return false;
+	}
+
+	float invDet = 1.0f / det;
+	float xx = m_element[4] * invDet;
+	float xy = -m_element[1] * invDet;
+	float yx = -m_element[3] * invDet;
+	float yy = m_element[0] * invDet;
+
+	inverse = Transform2D(xx, xy, -(xx * m_element[2] + xy * m_element[5]), yx, yy, -(yx * m_element[2] + yy * m_element[5]));
+
+	return true;
+}
+
+float Transform2D::ScaleFactor() const
+{
+	return sqrtf(fabsf(m_element[0] * m_element[4] - m_element[1] * m_element[3]));
+}
+
+bool Transform2D::IsIdentity() const
+{
+	return m_element[0] == 1.0f && m_element[1] == 0.0f && m_element[2] == 0.0f &&
+		m_element[3] == 0.0f && m_element[4] == 1.0f && m_element[5] == 0.0f;
+}
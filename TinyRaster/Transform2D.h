@@ -0,0 +1,44 @@
+#pragma once
+
+#include "TinyRasterTypes.h"
+
+//This class holds a 2D affine transform, the top two rows of a 3x3 matrix:
+//	x' = m[0] * x + m[1] * y + m[2]
+//	y' = m[3] * x + m[4] * y + m[5]
+class Transform2D
+{
+private:
+	float m_element[6];
+
+public:
+	//Create the identity transform
+	Transform2D();
+
+	Transform2D(float xx, float xy, float tx, float yx, float yy, float ty);
+
+	static Transform2D Translation(float tx, float ty);
+	static Transform2D Scale(float sx, float sy);
+	static Transform2D Rotation(float radians);
+
+	float operator [] (const int i) const;
+	float& operator [] (const int i);
+
+	//Compose two transforms, rhs is applied first
+	Transform2D operator * (const Transform2D& rhs) const;
+
+	//Transform a point
+	Vector2 Apply(const Vector2& p) const;
+
+	//Transform the positions of count vertices, colours and texture coordinates are copied unchanged
+	//Two positions are transformed per SSE operation, giving the same result as Apply() on each; dst may be src
+	void Apply(const Vertex2d* src, Vertex2d* dst, int count) const;
+
+	//Get the inverse transform
+	//output:	false if the transform is singular, inverse is then left unchanged
+	bool Inverse(Transform2D& inverse) const;
+
+	//Get the factor by which the transform scales lengths on average, the square root of its determinant
+	float ScaleFactor() const;
+
+	bool IsIdentity() const;
+};